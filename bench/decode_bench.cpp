@@ -0,0 +1,54 @@
+// 8 ֽڴֵ¶Աȣ vs SSSE3 vs AVX2CPU ֵ֧ʵֻ˻ر
+// ÷: decode_bench [values] [rounds]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "byteorder.h"
+
+using namespace hbase::thrift2;
+
+static double run(ByteOrderKernel kernel, const std::string &src, size_t count, int rounds, std::vector<uint64_t> &dst)
+{
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	for (int r = 0; r < rounds; ++r)
+	{
+		decodeBigEndian64(kernel, src.data(), count, dst.data());
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	return seconds * 1e9 / (static_cast<double>(count) * rounds);
+}
+
+int main(int argc, char *argv[])
+{
+	size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 4096;
+	int rounds = argc > 2 ? atoi(argv[2]) : 20000;
+
+	std::mt19937_64 rng(42);
+	std::vector<uint64_t> expect(count);
+	std::string src(count * 8, '\0');
+	for (size_t i = 0; i < count; ++i)		//  HBase Bytes.toBytes(long) ĸʽд
+	{
+		expect[i] = rng();
+		for (int b = 0; b < 8; ++b) src[i * 8 + b] = static_cast<char>(expect[i] >> (56 - 8 * b));
+	}
+
+	const ByteOrderKernel kernels[] = { BYTEORDER_SCALAR, BYTEORDER_SSSE3, BYTEORDER_AVX2 };
+	double ns[3];
+	std::vector<uint64_t> dst(count);
+	for (int k = 0; k < 3; ++k)
+	{
+		ns[k] = run(kernels[k], src, count, rounds, dst);
+		if (memcmp(dst.data(), expect.data(), count * 8) != 0)
+		{
+			fprintf(stderr, "kernel %d decoded wrong values\n", kernels[k]);
+			return 1;
+		}
+	}
+	printf("{\"values\":%zu,\"rounds\":%d,\"selected_kernel\":%d,\"scalar_ns_per_value\":%.3f,\"ssse3_ns_per_value\":%.3f,\"avx2_ns_per_value\":%.3f,\"speedup\":%.2f}\n",
+		count, rounds, getByteOrderKernel(), ns[0], ns[1], ns[2], ns[0] / ns[getByteOrderKernel()]);
+	return 0;
+}
@@ -0,0 +1,308 @@
+// ͻ˶˵ѹ⣺get/mulitget/put/mulitput/scan  CHBaseThrift/CHBaseQuery  thrift2 (ͨ mock_hbase_server)
+//  ߳ x ӳشС x С x ֵС x scan caching ɨÿһ JSONº p50/p99/p999 ӳ(΢)
+// ÷: mock_hbase_server --rows=100000 --columns=4 &
+//       hbase_bench [--host=127.0.0.1:9090] [--framed] [--compact] [--table=test] [--rows=100000] [--columns=4]
+//                   [--ops=get,mulitget,put,mulitput,scan] [--threads=1,8,32] [--pool=8,32] [--batch=16,128]
+//                   [--cell=8,1024] [--caching=100,1000] [--requests=2000] [--warmup=100]
+// бöŷָ--requests/--warmup Ϊÿ̵߳warmup ͳ
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "hbaseclient.h"
+
+using namespace hbase::thrift2;
+
+struct CBenchOptions
+{
+	std::string			host = "127.0.0.1:9090";
+	bool				framed = false;
+	bool				compact = false;
+	std::string			table = "test";
+	int					rows = 100000;		// мΧ mock_hbase_server --rows һ
+	int					columns = 4;		// д mock_hbase_server --columns һ
+	std::vector<std::string>	ops = { "get", "mulitget", "put", "mulitput", "scan" };
+	std::vector<int>	threads = { 1, 8, 32 };
+	std::vector<int>	pools = { 8, 32 };
+	std::vector<int>	batches = { 16, 128 };		// mulitget/mulitput ÿ
+	std::vector<int>	cells = { 8, 1024 };		// put/mulitput ÿֵֽ
+	std::vector<int>	cachings = { 100, 1000 };	// scan ÿ
+	int					requests = 2000;
+	int					warmup = 100;
+};
+
+struct CBenchCase
+{
+	std::string		op;
+	int				threads = 1;
+	int				pool = 1;
+	int				batch = 1;
+	int				cell = 0;
+	int				caching = 0;
+};
+
+// ִһ󣬷Ƿɹrows ۼӶд
+typedef std::function<bool(CHBaseQuery &query, std::mt19937 &rng, uint64_t &rows)> CBenchRequest;
+
+static std::string rowkey(int index)	//  mock_hbase_server Ԥݵмһ
+{
+	char row[32];
+	snprintf(row, sizeof(row), "row%010d", index);
+	return row;
+}
+
+static CBenchRequest makeRequest(const CBenchOptions &options, const CBenchCase &bench)
+{
+	std::string table = options.table;
+	int rows = options.rows > 0 ? options.rows : 1;
+	int columns = options.columns;
+	std::string value(bench.cell, 'v');
+	auto appendColumns = [columns](CGet &get) {
+		for (int c = 0; c < columns; ++c) get.appendColumn("f", "c" + std::to_string(c));
+	};
+	auto makePut = [columns, value](CPut &put, int index) {
+		put.setRowkey(rowkey(index));
+		for (int c = 0; c < columns; ++c) put.appendColumn("f", "c" + std::to_string(c), value);
+	};
+
+	if (bench.op == "get")
+	{
+		return [=](CHBaseQuery &query, std::mt19937 &rng, uint64_t &read) {
+			CGet get;
+			get.setRowkey(rowkey(std::uniform_int_distribution<int>(0, rows - 1)(rng)));
+			appendColumns(get);
+			if (!query.execGet(table, get)) return false;
+			while (query.nextRow()) ++read;
+			return true;
+		};
+	}
+	if (bench.op == "mulitget")
+	{
+		int batch = bench.batch;
+		return [=](CHBaseQuery &query, std::mt19937 &rng, uint64_t &read) {
+			CMulitGet mulit_get;
+			mulit_get.reserve(batch);
+			for (int i = 0; i < batch; ++i)
+			{
+				CGet get;
+				get.setRowkey(rowkey(std::uniform_int_distribution<int>(0, rows - 1)(rng)));
+				appendColumns(get);
+				mulit_get.appendGet(std::move(get));
+			}
+			if (!query.execMulitGet(table, mulit_get)) return false;
+			while (query.nextRow()) ++read;
+			return true;
+		};
+	}
+	if (bench.op == "put")
+	{
+		return [=](CHBaseQuery &query, std::mt19937 &rng, uint64_t &written) {
+			CPut put;
+			makePut(put, std::uniform_int_distribution<int>(0, rows - 1)(rng));
+			if (!query.execPut(table, put)) return false;
+			++written;
+			return true;
+		};
+	}
+	if (bench.op == "mulitput")
+	{
+		int batch = bench.batch;
+		return [=](CHBaseQuery &query, std::mt19937 &rng, uint64_t &written) {
+			CMulitPut mulit_put;
+			for (int i = 0; i < batch; ++i)
+			{
+				CPut put;
+				makePut(put, std::uniform_int_distribution<int>(0, rows - 1)(rng));
+				mulit_put.appendPut(put);
+			}
+			if (!query.execMulitPut(table, mulit_put)) return false;
+			written += batch;
+			return true;
+		};
+	}
+	if (bench.op == "scan")
+	{
+		int caching = bench.caching;
+		return [=](CHBaseQuery &query, std::mt19937 &rng, uint64_t &read) {
+			CScan scan;
+			scan.setRowRange(rowkey(std::uniform_int_distribution<int>(0, rows - 1)(rng)), "");
+			scan.setCaching(caching);
+			for (int c = 0; c < columns; ++c) scan.appendColumn("f", "c" + std::to_string(c));
+			if (!query.execScan(table, scan)) return false;
+			while (query.nextRow()) ++read;
+			return true;
+		};
+	}
+	return nullptr;
+}
+
+static uint64_t percentile(const std::vector<uint64_t> &sorted, double q)
+{
+	if (sorted.empty()) return 0;
+	size_t index = static_cast<size_t>(q * sorted.size());
+	return sorted[std::min(index, sorted.size() - 1)];
+}
+
+static void runCase(const CBenchOptions &options, const CBenchCase &bench)
+{
+	CBenchRequest request = makeRequest(options, bench);
+	if (!request)
+	{
+		fprintf(stderr, "unknown op %s\n", bench.op.c_str());
+		return;
+	}
+	CHBaseThrift &thrift = CHBaseThrift::instance();
+	thrift.close();
+	thrift.setHostlist(options.host);
+	thrift.setProtocol(options.framed ? THRIFT_TRANSPORT_FRAMED : THRIFT_TRANSPORT_BUFFERED, options.compact ? THRIFT_PROTOCOL_COMPACT : THRIFT_PROTOCOL_BINARY);
+	thrift.setAcquireTimeout(5000);		// ߳ʱŶӣŶʱӳ
+	if (!thrift.open(bench.pool))
+	{
+		fprintf(stderr, "open %s failed\n", options.host.c_str());
+		return;
+	}
+
+	std::vector<std::vector<uint64_t>> latencies(bench.threads);	// ÿ̸߳Լ¼ϲ⹲д
+	std::atomic<uint64_t> errors(0), rows(0);
+	std::atomic<int> ready(0);
+	std::atomic<bool> start(false);
+	std::chrono::steady_clock::time_point begin;
+	std::vector<std::thread> workers;
+	for (int t = 0; t < bench.threads; ++t)
+	{
+		workers.emplace_back([&, t]() {
+			std::mt19937 rng(t + 1);
+			uint64_t local_rows = 0, local_errors = 0;
+			auto once = [&](bool record) {
+				std::chrono::steady_clock::time_point issued = std::chrono::steady_clock::now();
+				CHBaseQuery *query = thrift.getQuery();
+				bool ok = query && request(*query, rng, local_rows);
+				if (query) thrift.releaseQuery(query, query->getConnection()->is_connected());
+				if (!record) return;
+				latencies[t].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - issued).count());
+				if (!ok) ++local_errors;
+			};
+			for (int i = 0; i < options.warmup; ++i) once(false);
+			local_rows = 0;
+			latencies[t].reserve(options.requests);
+			++ready;
+			while (!start.load()) std::this_thread::yield();
+			for (int i = 0; i < options.requests; ++i) once(true);
+			rows += local_rows;
+			errors += local_errors;
+		});
+	}
+	while (ready.load() < bench.threads) std::this_thread::yield();
+	begin = std::chrono::steady_clock::now();
+	start = true;
+	for (auto &worker : workers) worker.join();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	thrift.close();
+
+	std::vector<uint64_t> merged;
+	merged.reserve(static_cast<size_t>(bench.threads) * options.requests);
+	for (auto &latency : latencies) merged.insert(merged.end(), latency.begin(), latency.end());
+	std::sort(merged.begin(), merged.end());
+	uint64_t total = merged.size();
+	printf("{\"op\":\"%s\",\"threads\":%d,\"pool\":%d,\"batch\":%d,\"cell_size\":%d,\"caching\":%d,\"transport\":\"%s\",\"protocol\":\"%s\","
+		"\"requests\":%llu,\"errors\":%llu,\"rows\":%llu,\"seconds\":%.3f,\"requests_per_sec\":%.0f,\"rows_per_sec\":%.0f,"
+		"\"p50_us\":%.1f,\"p99_us\":%.1f,\"p999_us\":%.1f,\"max_us\":%.1f}\n",
+		bench.op.c_str(), bench.threads, bench.pool, bench.batch, bench.cell, bench.caching,
+		options.framed ? "framed" : "buffered", options.compact ? "compact" : "binary",
+		static_cast<unsigned long long>(total), static_cast<unsigned long long>(errors.load()), static_cast<unsigned long long>(rows.load()),
+		seconds, total / seconds, rows.load() / seconds,
+		percentile(merged, 0.50) / 1000.0, percentile(merged, 0.99) / 1000.0, percentile(merged, 0.999) / 1000.0,
+		(merged.empty() ? 0 : merged.back()) / 1000.0);
+	fflush(stdout);
+}
+
+static bool parseOption(const char *arg, const char *name, std::string &value)
+{
+	size_t len = strlen(name);
+	if (strncmp(arg, "--", 2) != 0 || strncmp(arg + 2, name, len) != 0) return false;
+	if (arg[2 + len] == '\0') value = "1";
+	else if (arg[2 + len] == '=') value = arg + 3 + len;
+	else return false;
+	return true;
+}
+
+static std::vector<std::string> splitList(const std::string &value)
+{
+	std::vector<std::string> items;
+	size_t begin = 0;
+	while (begin <= value.size())
+	{
+		size_t end = value.find(',', begin);
+		if (end == std::string::npos) end = value.size();
+		if (end > begin) items.push_back(value.substr(begin, end - begin));
+		begin = end + 1;
+	}
+	return items;
+}
+
+static std::vector<int> splitInts(const std::string &value)
+{
+	std::vector<int> items;
+	for (const std::string &item : splitList(value)) items.push_back(atoi(item.c_str()));
+	return items;
+}
+
+int main(int argc, char *argv[])
+{
+	CBenchOptions options;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string value;
+		if (parseOption(argv[i], "host", value)) options.host = value;
+		else if (parseOption(argv[i], "framed", value)) options.framed = value != "0";
+		else if (parseOption(argv[i], "compact", value)) options.compact = value != "0";
+		else if (parseOption(argv[i], "table", value)) options.table = value;
+		else if (parseOption(argv[i], "rows", value)) options.rows = atoi(value.c_str());
+		else if (parseOption(argv[i], "columns", value)) options.columns = atoi(value.c_str());
+		else if (parseOption(argv[i], "ops", value)) options.ops = splitList(value);
+		else if (parseOption(argv[i], "threads", value)) options.threads = splitInts(value);
+		else if (parseOption(argv[i], "pool", value)) options.pools = splitInts(value);
+		else if (parseOption(argv[i], "batch", value)) options.batches = splitInts(value);
+		else if (parseOption(argv[i], "cell", value)) options.cells = splitInts(value);
+		else if (parseOption(argv[i], "caching", value)) options.cachings = splitInts(value);
+		else if (parseOption(argv[i], "requests", value)) options.requests = atoi(value.c_str());
+		else if (parseOption(argv[i], "warmup", value)) options.warmup = atoi(value.c_str());
+		else
+		{
+			fprintf(stderr, "unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	for (const std::string &op : options.ops)	// ֻɨòصĲ
+	{
+		bool batched = op == "mulitget" || op == "mulitput";
+		bool written = op == "put" || op == "mulitput";
+		std::vector<int> batches = batched ? options.batches : std::vector<int>{ 1 };
+		std::vector<int> cells = written ? options.cells : std::vector<int>{ 0 };
+		std::vector<int> cachings = op == "scan" ? options.cachings : std::vector<int>{ 0 };
+		for (int threads : options.threads)
+		for (int pool : options.pools)
+		for (int batch : batches)
+		for (int cell : cells)
+		for (int caching : cachings)
+		{
+			CBenchCase bench;
+			bench.op = op;
+			bench.threads = threads;
+			bench.pool = pool;
+			bench.batch = batch;
+			bench.cell = cell;
+			bench.caching = caching;
+			runCase(options, bench);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,481 @@
+// ģ hbase thrift2 ˣݷڴ map ûмȺʱѹͻ
+// ֧ get/getMultiple/exists/put/putMultiple/deleteSingle/deleteMultiple/increment/openScanner/getScannerRows/closeScanner/
+// getScannerResults/getRegionLocation/getAllRegionLocationsfilterʱ䷶Χ汾ӿڷ TIOError
+// ÷: mock_hbase_server [--port=9090] [--threads=16] [--server=pool|threaded] [--framed] [--compact]
+//                         [--latency_us=0] [--jitter_us=0] [--fail_rate=0] [--idle_ms=0]
+//                         [--regions=1] [--table=test] [--rows=0] [--columns=4] [--value_size=8]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "boost/thread/shared_mutex.hpp"
+#include "boost/thread/locks.hpp"
+#include <thrift/concurrency/ThreadManager.h>
+#include <thrift/concurrency/PlatformThreadFactory.h>
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/protocol/TCompactProtocol.h>
+#include <thrift/server/TThreadPoolServer.h>
+#include <thrift/server/TThreadedServer.h>
+#include <thrift/transport/TServerSocket.h>
+#include <thrift/transport/TBufferTransports.h>
+#include "hbase/THBaseService.h"
+
+using namespace apache::hadoop::hbase::thrift2;
+
+struct CMockOptions
+{
+	int				port = 9090;
+	int				threads = 16;
+	std::string		server = "pool";
+	bool			framed = false;
+	bool			compact = false;
+	int				latency_us = 0;		// ÿ̶עӳ
+	int				jitter_us = 0;		// ڹ̶ӳټ [0, jitter_us) ӳ
+	double			fail_rate = 0;		// øʷ TIOError
+	int				idle_ms = 0;		// ӿгú˶Ͽ0 Ͽ
+	int				regions = 1;		// getAllRegionLocations صĺϳ region 
+	std::string		table = "test";		// Ԥݵı
+	int				rows = 0;			// Ԥõ
+	int				columns = 4;		// ÿеfamily ̶Ϊ fqualifier Ϊ c0c1...
+	int				value_size = 8;		// Ԥֵֽ8 ֽʱΪ longڲֵ
+};
+
+typedef std::pair<std::string, std::string>		CColumnKey;		// family, qualifier
+typedef std::pair<std::string, int64_t>			CCellValue;		// value, timestamp
+typedef std::map<CColumnKey, CCellValue>		CMockRow;
+typedef std::map<std::string, CMockRow>			CMockTable;
+
+static int64_t nowMillis()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static std::string encodeLong(int64_t value)	//  HBase Bytes.toBytes(long) һ
+{
+	std::string bytes(8, '\0');
+	for (int i = 0; i < 8; ++i) bytes[i] = static_cast<char>(static_cast<uint64_t>(value) >> (56 - 8 * i));
+	return bytes;
+}
+
+static int64_t decodeLong(const std::string &bytes)
+{
+	if (bytes.size() != 8) return 0;
+	uint64_t value = 0;
+	for (int i = 0; i < 8; ++i) value = (value << 8) | static_cast<unsigned char>(bytes[i]);
+	return static_cast<int64_t>(value);
+}
+
+class CMockHandler : public THBaseServiceIf
+{
+public:
+	explicit CMockHandler(const CMockOptions &options) :m_options(options), m_nextScanner(1), m_calls(0), m_failures(0)
+	{
+		preload();
+	}
+
+	bool exists(const std::string& table, const TGet& tget)
+	{
+		inject();
+		TResult result;
+		readRow(result, table, tget.row, tget.columns);
+		return !result.columnValues.empty();
+	}
+
+	void existsAll(std::vector<bool> & _return, const std::string& table, const std::vector<TGet> & tgets)
+	{
+		inject();
+		for (const TGet &tget : tgets)
+		{
+			TResult result;
+			readRow(result, table, tget.row, tget.columns);
+			_return.push_back(!result.columnValues.empty());
+		}
+	}
+
+	void get(TResult& _return, const std::string& table, const TGet& tget)
+	{
+		inject();
+		readRow(_return, table, tget.row, tget.columns);
+	}
+
+	void getMultiple(std::vector<TResult> & _return, const std::string& table, const std::vector<TGet> & tgets)
+	{
+		inject();
+		_return.resize(tgets.size());
+		for (size_t i = 0; i < tgets.size(); ++i) readRow(_return[i], table, tgets[i].row, tgets[i].columns);
+	}
+
+	void put(const std::string& table, const TPut& tput)
+	{
+		inject();
+		writeRow(table, tput);
+	}
+
+	void putMultiple(const std::string& table, const std::vector<TPut> & tputs)
+	{
+		inject();
+		for (const TPut &tput : tputs) writeRow(table, tput);
+	}
+
+	void deleteSingle(const std::string& table, const TDelete& tdelete)
+	{
+		inject();
+		deleteRow(table, tdelete);
+	}
+
+	void deleteMultiple(std::vector<TDelete> &, const std::string& table, const std::vector<TDelete> & tdeletes)	// ȫɹδɾб
+	{
+		inject();
+		for (const TDelete &tdelete : tdeletes) deleteRow(table, tdelete);
+	}
+
+	void increment(TResult& _return, const std::string& table, const TIncrement& tincrement)
+	{
+		inject();
+		boost::unique_lock<boost::shared_mutex> lk(m_mutex);
+		CMockRow &row = m_tables[table][tincrement.row];
+		_return.__set_row(tincrement.row);
+		int64_t timestamp = nowMillis();
+		for (const TColumnIncrement &column : tincrement.columns)
+		{
+			CCellValue &cell = row[CColumnKey(column.family, column.qualifier)];
+			cell.first = encodeLong(decodeLong(cell.first) + (column.__isset.amount ? column.amount : 1));
+			cell.second = timestamp;
+			appendColumn(_return, column.family, column.qualifier, cell);
+		}
+	}
+
+	int32_t openScanner(const std::string& table, const TScan& tscan)
+	{
+		inject();
+		std::lock_guard<std::mutex> lk(m_scannerMutex);
+		int32_t id = m_nextScanner++;
+		CScanner &scanner = m_scanners[id];
+		scanner.table = table;
+		scanner.scan = tscan;
+		scanner.started = false;
+		return id;
+	}
+
+	void getScannerRows(std::vector<TResult> & _return, const int32_t scannerId, const int32_t numRows)
+	{
+		inject();
+		CScanner scanner;
+		{
+			std::lock_guard<std::mutex> lk(m_scannerMutex);
+			std::map<int32_t, CScanner>::iterator iter = m_scanners.find(scannerId);
+			if (iter == m_scanners.end())
+			{
+				TIllegalArgument ia;
+				ia.__set_message("invalid scanner id");
+				throw ia;
+			}
+			scanner = iter->second;
+		}
+		scanRows(_return, scanner, numRows);
+		std::lock_guard<std::mutex> lk(m_scannerMutex);
+		std::map<int32_t, CScanner>::iterator iter = m_scanners.find(scannerId);
+		if (iter != m_scanners.end()) iter->second = scanner;
+	}
+
+	void closeScanner(const int32_t scannerId)
+	{
+		inject();
+		std::lock_guard<std::mutex> lk(m_scannerMutex);
+		m_scanners.erase(scannerId);
+	}
+
+	void getScannerResults(std::vector<TResult> & _return, const std::string& table, const TScan& tscan, const int32_t numRows)
+	{
+		inject();
+		CScanner scanner;
+		scanner.table = table;
+		scanner.scan = tscan;
+		scanner.started = false;
+		scanRows(_return, scanner, numRows);
+	}
+
+	void getRegionLocation(THRegionLocation& _return, const std::string& table, const std::string& row, const bool)
+	{
+		inject();
+		std::vector<THRegionLocation> regions;
+		regionLocations(regions, table);
+		for (const THRegionLocation &region : regions)
+		{
+			if (row >= region.regionInfo.startKey && (region.regionInfo.endKey.empty() || row < region.regionInfo.endKey)) _return = region;
+		}
+	}
+
+	void getAllRegionLocations(std::vector<THRegionLocation> & _return, const std::string& table)
+	{
+		inject();
+		regionLocations(_return, table);
+	}
+
+	bool checkAndPut(const std::string&, const std::string&, const std::string&, const std::string&, const std::string&, const TPut&) { unsupported("checkAndPut"); return false; }
+	bool checkAndDelete(const std::string&, const std::string&, const std::string&, const std::string&, const std::string&, const TDelete&) { unsupported("checkAndDelete"); return false; }
+	void append(TResult&, const std::string&, const TAppend&) { unsupported("append"); }
+	void mutateRow(const std::string&, const TRowMutations&) { unsupported("mutateRow"); }
+	bool checkAndMutate(const std::string&, const std::string&, const std::string&, const std::string&, const TCompareOp::type, const std::string&, const TRowMutations&) { unsupported("checkAndMutate"); return false; }
+
+	void report()
+	{
+		fprintf(stderr, "calls %llu injected failures %llu\n", static_cast<unsigned long long>(m_calls.load()), static_cast<unsigned long long>(m_failures.load()));
+	}
+private:
+	struct CScanner
+	{
+		std::string		table;
+		TScan			scan;
+		std::string		next;		// һʼ(ɨʱΪϽ)
+		bool			started;
+	};
+
+	void inject()	// עӳٺʧ
+	{
+		static thread_local std::mt19937 rng(std::random_device{}());
+		m_calls++;
+		int delay = m_options.latency_us;
+		if (m_options.jitter_us > 0) delay += std::uniform_int_distribution<int>(0, m_options.jitter_us - 1)(rng);
+		if (delay > 0) std::this_thread::sleep_for(std::chrono::microseconds(delay));
+		if (m_options.fail_rate > 0 && std::uniform_real_distribution<double>(0, 1)(rng) < m_options.fail_rate)
+		{
+			m_failures++;
+			TIOError io;
+			io.__set_message("injected failure");
+			throw io;
+		}
+	}
+
+	static void unsupported(const char *method)
+	{
+		TIOError io;
+		io.__set_message(std::string(method) + " is not supported by the mock server");
+		throw io;
+	}
+
+	static bool selected(const std::vector<TColumn> &columns, const CColumnKey &key)	// δָʱȫֻ family ʱظ family ȫ
+	{
+		if (columns.empty()) return true;
+		for (const TColumn &column : columns)
+		{
+			if (column.family == key.first && (!column.__isset.qualifier || column.qualifier == key.second)) return true;
+		}
+		return false;
+	}
+
+	static void appendColumn(TResult &result, const std::string &family, const std::string &qualifier, const CCellValue &cell)
+	{
+		TColumnValue value;
+		value.__set_family(family);
+		value.__set_qualifier(qualifier);
+		value.__set_value(cell.first);
+		value.__set_timestamp(cell.second);
+		result.columnValues.push_back(value);
+	}
+
+	static void fillResult(TResult &result, const std::string &row, const CMockRow &cells, const std::vector<TColumn> &columns)
+	{
+		result.__set_row(row);
+		for (const auto &cell : cells)
+		{
+			if (selected(columns, cell.first)) appendColumn(result, cell.first.first, cell.first.second, cell.second);
+		}
+	}
+
+	void readRow(TResult &result, const std::string &table, const std::string &row, const std::vector<TColumn> &columns)
+	{
+		boost::shared_lock<boost::shared_mutex> lk(m_mutex);
+		std::map<std::string, CMockTable>::const_iterator t = m_tables.find(table);
+		if (t == m_tables.end()) return;
+		CMockTable::const_iterator r = t->second.find(row);
+		if (r != t->second.end()) fillResult(result, row, r->second, columns);
+	}
+
+	void writeRow(const std::string &table, const TPut &tput)
+	{
+		int64_t timestamp = nowMillis();
+		boost::unique_lock<boost::shared_mutex> lk(m_mutex);
+		CMockRow &row = m_tables[table][tput.row];
+		for (const TColumnValue &column : tput.columnValues)
+		{
+			row[CColumnKey(column.family, column.qualifier)] = CCellValue(column.value, column.__isset.timestamp ? column.timestamp : timestamp);
+		}
+	}
+
+	void deleteRow(const std::string &table, const TDelete &tdelete)
+	{
+		boost::unique_lock<boost::shared_mutex> lk(m_mutex);
+		std::map<std::string, CMockTable>::iterator t = m_tables.find(table);
+		if (t == m_tables.end()) return;
+		CMockTable::iterator r = t->second.find(tdelete.row);
+		if (r == t->second.end()) return;
+		for (CMockRow::iterator cell = r->second.begin(); cell != r->second.end();)
+		{
+			if (selected(tdelete.columns, cell->first)) cell = r->second.erase(cell);
+			else ++cell;
+		}
+		if (r->second.empty()) t->second.erase(r);
+	}
+
+	void scanRows(std::vector<TResult> &results, CScanner &scanner, int32_t numRows)
+	{
+		const TScan &scan = scanner.scan;
+		boost::shared_lock<boost::shared_mutex> lk(m_mutex);
+		std::map<std::string, CMockTable>::const_iterator t = m_tables.find(scanner.table);
+		if (t == m_tables.end()) return;
+		const CMockTable &rows = t->second;
+		if (!scan.reversed)
+		{
+			CMockTable::const_iterator r = scanner.started ? rows.upper_bound(scanner.next) : rows.lower_bound(scan.startRow);
+			for (; r != rows.end() && static_cast<int32_t>(results.size()) < numRows; ++r)
+			{
+				if (!scan.stopRow.empty() && r->first >= scan.stopRow) break;
+				results.emplace_back();
+				fillResult(results.back(), r->first, r->second, scan.columns);
+				scanner.next = r->first;
+				scanner.started = true;
+			}
+			return;
+		}
+		CMockTable::const_reverse_iterator r(scanner.started ? rows.lower_bound(scanner.next) :		// : startRow ΪϽ磬stopRow Ϊ½
+			(scan.startRow.empty() ? rows.end() : rows.upper_bound(scan.startRow)));
+		for (; r != rows.rend() && static_cast<int32_t>(results.size()) < numRows; ++r)
+		{
+			if (!scan.stopRow.empty() && r->first <= scan.stopRow) break;
+			results.emplace_back();
+			fillResult(results.back(), r->first, r->second, scan.columns);
+			scanner.next = r->first;
+			scanner.started = true;
+		}
+	}
+
+	void regionLocations(std::vector<THRegionLocation> &regions, const std::string &table)	//  m_splits гĺϳ regionȫλڱ
+	{
+		for (size_t i = 0; i <= m_splits.size(); ++i)
+		{
+			THRegionInfo info;
+			info.__set_regionId(static_cast<int64_t>(i + 1));
+			info.__set_tableName(table);
+			info.__set_startKey(i == 0 ? std::string() : m_splits[i - 1]);
+			info.__set_endKey(i == m_splits.size() ? std::string() : m_splits[i]);
+			TServerName server;
+			server.__set_hostName("localhost");
+			server.__set_port(m_options.port);
+			THRegionLocation location;
+			location.__set_serverName(server);
+			location.__set_regionInfo(info);
+			regions.push_back(location);
+		}
+	}
+
+	void preload()	// Ԥ rows Уregion Ԥݾ֣ûԤʱֽھ
+	{
+		char row[32];
+		int64_t timestamp = nowMillis();
+		CMockTable &table = m_tables[m_options.table];
+		for (int i = 0; i < m_options.rows; ++i)
+		{
+			snprintf(row, sizeof(row), "row%010d", i);
+			CMockRow &cells = table[row];
+			for (int c = 0; c < m_options.columns; ++c)
+			{
+				std::string value = m_options.value_size == 8 ? encodeLong(i * 1000 + c) : std::string(m_options.value_size, static_cast<char>('a' + c % 26));
+				cells[CColumnKey("f", "c" + std::to_string(c))] = CCellValue(value, timestamp);
+			}
+		}
+		for (int i = 1; i < m_options.regions; ++i)
+		{
+			if (m_options.rows > 0)
+			{
+				snprintf(row, sizeof(row), "row%010d", static_cast<int>(static_cast<int64_t>(m_options.rows) * i / m_options.regions));
+				m_splits.push_back(row);
+			}
+			else m_splits.push_back(std::string(1, static_cast<char>(256 * i / m_options.regions)));
+		}
+	}
+
+	CMockOptions									m_options;
+	boost::shared_mutex								m_mutex;
+	std::map<std::string, CMockTable>				m_tables;
+	std::vector<std::string>						m_splits;
+	std::mutex										m_scannerMutex;
+	std::map<int32_t, CScanner>						m_scanners;
+	int32_t											m_nextScanner;
+	std::atomic<uint64_t>							m_calls;
+	std::atomic<uint64_t>							m_failures;
+};
+
+static bool parseOption(const char *arg, const char *name, std::string &value)
+{
+	size_t len = strlen(name);
+	if (strncmp(arg, "--", 2) != 0 || strncmp(arg + 2, name, len) != 0) return false;
+	if (arg[2 + len] == '\0') value = "1";
+	else if (arg[2 + len] == '=') value = arg + 3 + len;
+	else return false;
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	CMockOptions options;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string value;
+		if (parseOption(argv[i], "port", value)) options.port = atoi(value.c_str());
+		else if (parseOption(argv[i], "threads", value)) options.threads = atoi(value.c_str());
+		else if (parseOption(argv[i], "server", value)) options.server = value;
+		else if (parseOption(argv[i], "framed", value)) options.framed = value != "0";
+		else if (parseOption(argv[i], "compact", value)) options.compact = value != "0";
+		else if (parseOption(argv[i], "latency_us", value)) options.latency_us = atoi(value.c_str());
+		else if (parseOption(argv[i], "jitter_us", value)) options.jitter_us = atoi(value.c_str());
+		else if (parseOption(argv[i], "fail_rate", value)) options.fail_rate = atof(value.c_str());
+		else if (parseOption(argv[i], "idle_ms", value)) options.idle_ms = atoi(value.c_str());
+		else if (parseOption(argv[i], "regions", value)) options.regions = atoi(value.c_str());
+		else if (parseOption(argv[i], "table", value)) options.table = value;
+		else if (parseOption(argv[i], "rows", value)) options.rows = atoi(value.c_str());
+		else if (parseOption(argv[i], "columns", value)) options.columns = atoi(value.c_str());
+		else if (parseOption(argv[i], "value_size", value)) options.value_size = atoi(value.c_str());
+		else
+		{
+			fprintf(stderr, "unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	std::shared_ptr<CMockHandler> handler = std::make_shared<CMockHandler>(options);
+	std::shared_ptr<apache::thrift::TProcessor> processor = std::make_shared<THBaseServiceProcessor>(handler);
+	std::shared_ptr<apache::thrift::transport::TServerSocket> socket = std::make_shared<apache::thrift::transport::TServerSocket>(options.port);
+	if (options.idle_ms > 0) socket->setRecvTimeout(options.idle_ms);	// ʱϿӣģػճ
+	std::shared_ptr<apache::thrift::transport::TTransportFactory> transport;
+	if (options.framed) transport = std::make_shared<apache::thrift::transport::TFramedTransportFactory>();
+	else transport = std::make_shared<apache::thrift::transport::TBufferedTransportFactory>();
+	std::shared_ptr<apache::thrift::protocol::TProtocolFactory> protocol;
+	if (options.compact) protocol = std::make_shared<apache::thrift::protocol::TCompactProtocolFactory>();
+	else protocol = std::make_shared<apache::thrift::protocol::TBinaryProtocolFactory>();
+
+	std::unique_ptr<apache::thrift::server::TServer> server;
+	if (options.server == "threaded")	// ÿһ̣߳ʱ
+	{
+		server.reset(new apache::thrift::server::TThreadedServer(processor, socket, transport, protocol));
+	}
+	else	// ̶߳߳ŶӣĬϵ̳߳ģʽһ
+	{
+		std::shared_ptr<apache::thrift::concurrency::ThreadManager> manager = apache::thrift::concurrency::ThreadManager::newSimpleThreadManager(options.threads);
+		manager->threadFactory(std::make_shared<apache::thrift::concurrency::PlatformThreadFactory>());
+		manager->start();
+		server.reset(new apache::thrift::server::TThreadPoolServer(processor, socket, transport, protocol, manager));
+	}
+	fprintf(stderr, "mock hbase thrift2 server on port %d (%s, %s, %s), table %s rows %d regions %d\n", options.port, options.server.c_str(),
+		options.framed ? "framed" : "buffered", options.compact ? "compact" : "binary", options.table.c_str(), options.rows, options.regions);
+	server->serve();
+	handler->report();
+	return 0;
+}
@@ -0,0 +1,65 @@
+// ӳؿжеĻȡ/黹¶Աȣthreadsafe_list(ڵ) vs lockfree_bounded_queue
+// ÷: pool_bench [threads] [pool_size] [ops_per_thread]
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+#include "container.h"
+
+struct CFakeConn
+{
+	int id;
+};
+
+template<class Acquire, class Release>
+static double run(int threads, int ops, Acquire acquire, Release release)
+{
+	std::atomic<bool> start(false);
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; ++t)
+	{
+		workers.emplace_back([&]() {
+			while (!start.load()) std::this_thread::yield();
+			for (int i = 0; i < ops;)	// ֻͳƳɹ ȡ+黹ؿʱ
+			{
+				std::shared_ptr<CFakeConn> conn = acquire();
+				if (!conn) continue;
+				release(conn);
+				++i;
+			}
+		});
+	}
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	start = true;
+	for (auto &worker : workers) worker.join();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	return threads * static_cast<double>(ops) / seconds;
+}
+
+int main(int argc, char *argv[])
+{
+	int threads = argc > 1 ? atoi(argv[1]) : 64;
+	int pool_size = argc > 2 ? atoi(argv[2]) : 32;
+	int ops = argc > 3 ? atoi(argv[3]) : 200000;
+
+	threadsafe_list<CFakeConn> list;
+	lockfree_bounded_queue<std::shared_ptr<CFakeConn>> ring(pool_size);
+	for (int i = 0; i < pool_size; ++i)
+	{
+		std::shared_ptr<CFakeConn> conn = std::make_shared<CFakeConn>();
+		conn->id = i;
+		list.push_front(conn);
+		ring.push(conn);
+	}
+
+	double list_ops = run(threads, ops,
+		[&list]() { return list.pop_front(); },
+		[&list](const std::shared_ptr<CFakeConn> &conn) { list.push_front(conn); });
+	double ring_ops = run(threads, ops,
+		[&ring]() { std::shared_ptr<CFakeConn> conn; ring.pop(conn); return conn; },
+		[&ring](const std::shared_ptr<CFakeConn> &conn) { ring.push(conn); });
+
+	printf("{\"threads\":%d,\"pool_size\":%d,\"ops_per_thread\":%d,\"threadsafe_list_ops_per_sec\":%.0f,\"lockfree_ring_ops_per_sec\":%.0f,\"speedup\":%.2f}\n",
+		threads, pool_size, ops, list_ops, ring_ops, ring_ops / list_ops);
+	return 0;
+}
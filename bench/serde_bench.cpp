@@ -0,0 +1,304 @@
+// thrift ΢׼TResult б(getMultiple Ӧ)TPut б(putMultiple )TScan(openScanner )  TMemoryBuffer /
+// Ա binary/compact Э顢ӿЭ(TBinaryProtocol)밴 TMemoryBuffer ʵЭ(TBinaryProtocolT<TMemoryBuffer>)
+// ɴ TResult  CResultBatch ֱӽ룬ÿһ JSONns/cell  allocs/cell
+// ÷: serde_bench [rows=100] [cells=1,10,100] [value_size=8,128,1024] [iterations=200]
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/protocol/TCompactProtocol.h>
+#include <thrift/transport/TBufferTransports.h>
+#include "hbase/THBaseService.h"
+#include "resultbatch.h"
+
+using namespace apache::hadoop::hbase::thrift2;
+using apache::thrift::transport::TMemoryBuffer;
+
+static std::atomic<uint64_t> g_allocs(0);		// ȫ operator new ĵô
+
+// 滻ȫ new/delete ʽdelete 䵽 freedelete  gcc ڵõ㿴 operator new ָ뱻 free  -Wmismatched-new-delete
+#define NOINLINE __attribute__((noinline))
+
+void *operator new(size_t size)
+{
+	g_allocs.fetch_add(1, std::memory_order_relaxed);
+	void *ptr = malloc(size ? size : 1);
+	if (!ptr) throw std::bad_alloc();
+	return ptr;
+}
+
+void *operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+NOINLINE void operator delete(void *ptr) noexcept
+{
+	free(ptr);
+}
+
+NOINLINE void operator delete[](void *ptr) noexcept
+{
+	operator delete(ptr);
+}
+
+NOINLINE void operator delete(void *ptr, size_t) noexcept
+{
+	operator delete(ptr);
+}
+
+NOINLINE void operator delete[](void *ptr, size_t) noexcept
+{
+	operator delete(ptr);
+}
+
+#ifdef __cpp_aligned_new
+void *operator new(size_t size, std::align_val_t align)
+{
+	g_allocs.fetch_add(1, std::memory_order_relaxed);
+	size_t alignment = static_cast<size_t>(align);
+	void *ptr = aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+	if (!ptr) throw std::bad_alloc();
+	return ptr;
+}
+
+void *operator new[](size_t size, std::align_val_t align)
+{
+	return operator new(size, align);
+}
+
+NOINLINE void operator delete(void *ptr, std::align_val_t) noexcept
+{
+	free(ptr);
+}
+
+NOINLINE void operator delete[](void *ptr, std::align_val_t align) noexcept
+{
+	operator delete(ptr, align);
+}
+
+NOINLINE void operator delete(void *ptr, size_t, std::align_val_t align) noexcept
+{
+	operator delete(ptr, align);
+}
+
+NOINLINE void operator delete[](void *ptr, size_t, std::align_val_t align) noexcept
+{
+	operator delete(ptr, align);
+}
+#endif
+
+struct CSerdeCase
+{
+	int			rows;
+	int			cells;			// ÿеTScan ʱΪ
+	int			value_size;
+	int			iterations;
+};
+
+static void report(const char *name, const char *protocol, const char *impl, const CSerdeCase &serde, uint64_t cells, uint32_t bytes, double ns, uint64_t allocs)
+{
+	printf("{\"case\":\"%s\",\"protocol\":\"%s\",\"impl\":\"%s\",\"rows\":%d,\"cells_per_row\":%d,\"value_size\":%d,\"bytes\":%u,"
+		"\"ns_per_cell\":%.2f,\"allocs_per_cell\":%.3f}\n",
+		name, protocol, impl, serde.rows, serde.cells, serde.value_size, bytes, ns / cells, static_cast<double>(allocs) / cells);
+	fflush(stdout);
+}
+
+template<class Func>
+static void measure(const char *name, const char *protocol, const char *impl, const CSerdeCase &serde, uint64_t cells_per_iteration, uint32_t bytes, Func func)
+{
+	func();		// ԤһΣøõĻȶ
+	uint64_t allocs = g_allocs.load();
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < serde.iterations; ++i) func();
+	double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+	uint64_t cells = cells_per_iteration * serde.iterations;
+	report(name, protocol, impl, serde, cells, bytes, ns, g_allocs.load() - allocs);
+}
+
+static std::vector<TResult> makeResults(const CSerdeCase &serde)
+{
+	std::vector<TResult> results(serde.rows);
+	char row[32];
+	for (int r = 0; r < serde.rows; ++r)
+	{
+		snprintf(row, sizeof(row), "row%010d", r);
+		results[r].__set_row(row);
+		results[r].columnValues.resize(serde.cells);
+		for (int c = 0; c < serde.cells; ++c)
+		{
+			TColumnValue &column = results[r].columnValues[c];
+			column.__set_family("f");
+			column.__set_qualifier("c" + std::to_string(c));
+			column.__set_value(std::string(serde.value_size, static_cast<char>('a' + c % 26)));
+			column.__set_timestamp(1500000000000LL + r);
+		}
+	}
+	return results;
+}
+
+static std::vector<TPut> makePuts(const std::vector<TResult> &results)
+{
+	std::vector<TPut> puts(results.size());
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		puts[i].__set_row(results[i].row);
+		puts[i].__set_columnValues(results[i].columnValues);
+	}
+	return puts;
+}
+
+static TScan makeScan(const CSerdeCase &serde)
+{
+	TScan scan;
+	scan.__set_startRow("row0000000000");
+	scan.__set_stopRow("row9999999999");
+	std::vector<TColumn> columns(serde.cells);
+	for (int c = 0; c < serde.cells; ++c)
+	{
+		columns[c].__set_family("f");
+		columns[c].__set_qualifier("c" + std::to_string(c));
+	}
+	scan.__set_columns(columns);
+	scan.__set_caching(serde.rows * serde.cells);
+	scan.__set_filterString("SingleColumnValueFilter('f', 'c0', =, 'binary:a')");
+	return scan;
+}
+
+template<class Protocol>
+static void run(const char *protocol, const char *impl, const CSerdeCase &serde)
+{
+	std::shared_ptr<TMemoryBuffer> output = std::make_shared<TMemoryBuffer>();	// 룬
+	std::shared_ptr<TMemoryBuffer> input = std::make_shared<TMemoryBuffer>();	// 룬ֻ۲ encoded 
+	Protocol oprot(output);
+	Protocol iprot(input);
+	uint8_t *data = NULL;
+	uint32_t size = 0;
+	uint64_t cells = static_cast<uint64_t>(serde.rows) * serde.cells;
+
+	// getMultiple Ӧ: ˱룬ͻ˽
+	std::vector<TResult> results = makeResults(serde);
+	THBaseService_getMultiple_result reply;
+	reply.__set_success(results);
+	auto writeReply = [&]() {
+		output->resetBuffer();
+		oprot.writeMessageBegin("getMultiple", apache::thrift::protocol::T_REPLY, 0);
+		reply.write(&oprot);
+		oprot.writeMessageEnd();
+	};
+	writeReply();
+	output->getBuffer(&data, &size);
+	std::string encoded(reinterpret_cast<char *>(data), size);		// õĸoutput ֮󻹻Ḵ
+	uint32_t reply_bytes = size;
+	measure("result_encode", protocol, impl, serde, cells, reply_bytes, writeReply);
+	measure("result_decode_generated", protocol, impl, serde, cells, reply_bytes, [&]() {	// ԭ recv_getMultiple ͬÿ½ vector<TResult>
+		input->resetBuffer(reinterpret_cast<uint8_t *>(&encoded[0]), reply_bytes);
+		std::string fname;
+		apache::thrift::protocol::TMessageType mtype;
+		int32_t seqid = 0;
+		std::vector<TResult> decoded;
+		iprot.readMessageBegin(fname, mtype, seqid);
+		THBaseService_getMultiple_presult presult;
+		presult.success = &decoded;
+		presult.read(&iprot);
+		iprot.readMessageEnd();
+	});
+	hbase::thrift2::CResultBatch batch;
+	measure("result_decode_batch", protocol, impl, serde, cells, reply_bytes, [&]() {		// 뵽õ CResultBatch(arena + ͼ)
+		input->resetBuffer(reinterpret_cast<uint8_t *>(&encoded[0]), reply_bytes);
+		batch.recvResults(&iprot, "getMultiple");
+	});
+
+	// putMultiple : ͻ˱룬˽
+	std::string table = "test";
+	std::vector<TPut> puts = makePuts(results);
+	THBaseService_putMultiple_pargs pargs;
+	pargs.table = &table;
+	pargs.tputs = &puts;
+	auto writePuts = [&]() {
+		output->resetBuffer();
+		oprot.writeMessageBegin("putMultiple", apache::thrift::protocol::T_CALL, 0);
+		pargs.write(&oprot);
+		oprot.writeMessageEnd();
+	};
+	writePuts();
+	output->getBuffer(&data, &size);
+	encoded.assign(reinterpret_cast<char *>(data), size);
+	uint32_t put_bytes = size;
+	measure("put_encode", protocol, impl, serde, cells, put_bytes, writePuts);
+	measure("put_decode_generated", protocol, impl, serde, cells, put_bytes, [&]() {
+		input->resetBuffer(reinterpret_cast<uint8_t *>(&encoded[0]), put_bytes);
+		std::string fname;
+		apache::thrift::protocol::TMessageType mtype;
+		int32_t seqid = 0;
+		THBaseService_putMultiple_args args;
+		iprot.readMessageBegin(fname, mtype, seqid);
+		args.read(&iprot);
+		iprot.readMessageEnd();
+	});
+
+	// openScanner : Ϊ cellsм
+	TScan scan = makeScan(serde);
+	THBaseService_openScanner_pargs scan_args;
+	scan_args.table = &table;
+	scan_args.tscan = &scan;
+	auto writeScan = [&]() {
+		output->resetBuffer();
+		oprot.writeMessageBegin("openScanner", apache::thrift::protocol::T_CALL, 0);
+		scan_args.write(&oprot);
+		oprot.writeMessageEnd();
+	};
+	writeScan();
+	output->getBuffer(&data, &size);
+	encoded.assign(reinterpret_cast<char *>(data), size);
+	uint32_t scan_bytes = size;
+	uint64_t scan_cells = serde.cells > 0 ? serde.cells : 1;
+	measure("scan_encode", protocol, impl, serde, scan_cells, scan_bytes, writeScan);
+	measure("scan_decode_generated", protocol, impl, serde, scan_cells, scan_bytes, [&]() {
+		input->resetBuffer(reinterpret_cast<uint8_t *>(&encoded[0]), scan_bytes);
+		std::string fname;
+		apache::thrift::protocol::TMessageType mtype;
+		int32_t seqid = 0;
+		THBaseService_openScanner_args args;
+		iprot.readMessageBegin(fname, mtype, seqid);
+		args.read(&iprot);
+		iprot.readMessageEnd();
+	});
+}
+
+static std::vector<int> splitInts(const char *value)
+{
+	std::vector<int> items;
+	for (const char *begin = value; *begin;)
+	{
+		items.push_back(atoi(begin));
+		while (*begin && *begin != ',') ++begin;
+		if (*begin == ',') ++begin;
+	}
+	return items;
+}
+
+int main(int argc, char *argv[])
+{
+	int rows = argc > 1 ? atoi(argv[1]) : 100;
+	std::vector<int> cells = splitInts(argc > 2 ? argv[2] : "1,10,100");
+	std::vector<int> value_sizes = splitInts(argc > 3 ? argv[3] : "8,128,1024");
+	int iterations = argc > 4 ? atoi(argv[4]) : 200;
+
+	for (int cell : cells)
+	{
+		for (int value_size : value_sizes)
+		{
+			CSerdeCase serde = { rows, cell, value_size, iterations };
+			run<apache::thrift::protocol::TBinaryProtocol>("binary", "virtual", serde);
+			run<apache::thrift::protocol::TBinaryProtocolT<TMemoryBuffer>>("binary", "memory_buffer", serde);
+			run<apache::thrift::protocol::TCompactProtocol>("compact", "virtual", serde);
+			run<apache::thrift::protocol::TCompactProtocolT<TMemoryBuffer>>("compact", "memory_buffer", serde);
+		}
+	}
+	return 0;
+}
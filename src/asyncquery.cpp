@@ -0,0 +1,192 @@
+#include "asyncquery.h"
+#include "sharedclient.h"
+#include "log.h"
+
+namespace hbase {
+	namespace thrift2 {
+
+		CHBaseAsync::CHBaseAsync(CHBaseThrift &thrift) :m_thrift(thrift)
+		{
+		}
+
+		CHBaseAsync::~CHBaseAsync()
+		{
+			close();
+		}
+
+		bool CHBaseAsync::open(int threads, size_t queue_size)
+		{
+			close();
+			m_jobs.reset(new threadsafe_bounded_queue<std::function<void()>>(queue_size > 0 ? queue_size : 1));
+			for (int i = 0; i < (threads > 0 ? threads : 1); ++i)
+			{
+				m_workers.emplace_back(&CHBaseAsync::worker, this);
+			}
+			return true;
+		}
+
+		void CHBaseAsync::close()
+		{
+			if (!m_jobs) return;
+			m_jobs->close();		// ӵԻᱻȡ
+			for (auto &worker : m_workers) worker.join();
+			m_workers.clear();
+			m_jobs.reset();
+		}
+
+		void CHBaseAsync::worker()
+		{
+			std::function<void()> job;
+			while (m_jobs->pop(job))
+			{
+				job();
+				job = nullptr;		// ͷеͽ
+			}
+		}
+
+		bool CHBaseAsync::post(std::function<void()> &&job)
+		{
+			return m_jobs && m_jobs->push(std::move(job));
+		}
+
+		std::future<CAsyncResult> CHBaseAsync::submit(const CTask &task)
+		{
+			std::shared_ptr<std::promise<CAsyncResult>> promise = std::make_shared<std::promise<CAsyncResult>>();
+			std::future<CAsyncResult> future = promise->get_future();
+			if (!post([promise, task]() { promise->set_value(task()); }))
+			{
+				CAsyncResult result;
+				result.error = HBASE_TRANSPORT_ERROR;
+				promise->set_value(std::move(result));
+			}
+			return future;
+		}
+
+		void CHBaseAsync::submit(const CTask &task, const CAsyncCallback &callback)
+		{
+			if (!post([task, callback]() { CAsyncResult result = task(); callback(result); }))
+			{
+				CAsyncResult result;
+				result.error = HBASE_TRANSPORT_ERROR;
+				callback(result);
+			}
+		}
+
+		template<class SharedCall, class QueryCall>
+		CAsyncResult CHBaseAsync::execute(SharedCall shared_call, QueryCall query_call)
+		{
+			CAsyncResult result;
+			result.error = HBASE_TRANSPORT_ERROR;
+			CHBaseSharedClient *shared = m_thrift.getSharedClient();
+			if (shared)
+			{
+				result.error = shared_call(*shared, result.rows);
+				return result;
+			}
+			CHBaseQuery *query = m_thrift.getQuery();
+			if (!query) return result;
+			result.error = query_call(*query) ? HBASE_OK : query->getLastError();
+			query->swapResult(result.rows);
+			m_thrift.releaseQuery(query, query->getConnection()->is_connected());
+			return result;
+		}
+
+		CHBaseAsync::CTask CHBaseAsync::makeGet(const std::string &table, const CGet &get)
+		{
+			return [this, table, get = get]() mutable {	// ֵȥ constexec* Ҫ const 
+				return execute([&](CHBaseSharedClient &shared, CResultBatch &rows) { return shared.execGet(table, get, rows); },
+					[&](CHBaseQuery &query) { return query.execGet(table, get); });
+			};
+		}
+
+		CHBaseAsync::CTask CHBaseAsync::makeMulitGet(const std::string &table, const CMulitGet &mulit_get)
+		{
+			return [this, table, mulit_get = mulit_get]() mutable {
+				return execute([&](CHBaseSharedClient &shared, CResultBatch &rows) { return shared.execMulitGet(table, mulit_get, rows); },
+					[&](CHBaseQuery &query) { return query.execMulitGet(table, mulit_get); });
+			};
+		}
+
+		CHBaseAsync::CTask CHBaseAsync::makeScan(const std::string &table, const CScan &scan)
+		{
+			return [this, table, scan = scan]() mutable {
+				return execute([&](CHBaseSharedClient &shared, CResultBatch &rows) { return shared.execScan(table, scan, rows); },
+					[&](CHBaseQuery &query) { return query.execScan(table, scan); });
+			};
+		}
+
+		CHBaseAsync::CTask CHBaseAsync::makePut(const std::string &table, const CPut &put)
+		{
+			return [this, table, put = put]() mutable {
+				return execute([&](CHBaseSharedClient &shared, CResultBatch &) { return shared.execPut(table, put); },
+					[&](CHBaseQuery &query) { return query.execPut(table, put); });
+			};
+		}
+
+		CHBaseAsync::CTask CHBaseAsync::makeMulitPut(const std::string &table, const CMulitPut &mulit_put)
+		{
+			return [this, table, mulit_put = mulit_put]() mutable {
+				return execute([&](CHBaseSharedClient &shared, CResultBatch &) { return shared.execMulitPut(table, mulit_put); },
+					[&](CHBaseQuery &query) { return query.execMulitPut(table, mulit_put); });
+			};
+		}
+
+		std::future<CAsyncResult> CHBaseAsync::execGetAsync(const std::string &table, const CGet &get)
+		{
+			return submit(makeGet(table, get));
+		}
+
+		std::future<CAsyncResult> CHBaseAsync::execMulitGetAsync(const std::string &table, const CMulitGet &mulit_get)
+		{
+			return submit(makeMulitGet(table, mulit_get));
+		}
+
+		std::future<CAsyncResult> CHBaseAsync::execScanAsync(const std::string &table, const CScan &scan)
+		{
+			return submit(makeScan(table, scan));
+		}
+
+		std::future<CAsyncResult> CHBaseAsync::execPutAsync(const std::string &table, const CPut &put)
+		{
+			return submit(makePut(table, put));
+		}
+
+		std::future<CAsyncResult> CHBaseAsync::execMulitPutAsync(const std::string &table, const CMulitPut &mulit_put)
+		{
+			return submit(makeMulitPut(table, mulit_put));
+		}
+
+		void CHBaseAsync::execGetAsync(const std::string &table, const CGet &get, const CAsyncCallback &callback)
+		{
+			submit(makeGet(table, get), callback);
+		}
+
+		void CHBaseAsync::execMulitGetAsync(const std::string &table, const CMulitGet &mulit_get, const CAsyncCallback &callback)
+		{
+			submit(makeMulitGet(table, mulit_get), callback);
+		}
+
+		void CHBaseAsync::execScanAsync(const std::string &table, const CScan &scan, const CAsyncCallback &callback)
+		{
+			submit(makeScan(table, scan), callback);
+		}
+
+		void CHBaseAsync::execPutAsync(const std::string &table, const CPut &put, const CAsyncCallback &callback)
+		{
+			submit(makePut(table, put), callback);
+		}
+
+		void CHBaseAsync::execMulitPutAsync(const std::string &table, const CMulitPut &mulit_put, const CAsyncCallback &callback)
+		{
+			submit(makeMulitPut(table, mulit_put), callback);
+		}
+
+		std::vector<CAsyncResult> CHBaseAsync::waitAll(std::vector<std::future<CAsyncResult>> &futures)
+		{
+			std::vector<CAsyncResult> results;
+			results.reserve(futures.size());
+			for (auto &future : futures) results.push_back(future.get());
+			return results;
+		}
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <future>
+#include <functional>
+#include <thread>
+#include "hbaseclient.h"
+
+namespace hbase {
+	namespace thrift2 {
+
+		struct CAsyncResult
+		{
+			HBaseError		error;
+			CResultBatch	rows;		// get/scan Ľput/delete Ϊ
+		};
+		typedef std::function<void(CAsyncResult &)> CAsyncCallback;		// ڲ߳ϻصҪڻصﳤʱ
+
+		// 첽ѯ󿽱һݺŽڲִ̳߳У÷ future ڻصȡ
+		//  setSharedConnections ʱ߹ӣÿӳȡһѯ黹
+		// ʱύ̰߳ȫ
+		class CHBaseAsync
+		{
+		public:
+			explicit CHBaseAsync(CHBaseThrift &thrift);
+			~CHBaseAsync();
+
+			bool open(int threads = 8, size_t queue_size = 1024);
+			void close();												// ִύ˳֮ύֱӷ HBASE_TRANSPORT_ERROR
+			std::future<CAsyncResult> execGetAsync(const std::string &table, const CGet &get);
+			std::future<CAsyncResult> execMulitGetAsync(const std::string &table, const CMulitGet &mulit_get);
+			std::future<CAsyncResult> execScanAsync(const std::string &table, const CScan &scan);	// һȡȫУͬ CHBaseQuery::execScan
+			std::future<CAsyncResult> execPutAsync(const std::string &table, const CPut &put);
+			std::future<CAsyncResult> execMulitPutAsync(const std::string &table, const CMulitPut &mulit_put);
+			void execGetAsync(const std::string &table, const CGet &get, const CAsyncCallback &callback);
+			void execMulitGetAsync(const std::string &table, const CMulitGet &mulit_get, const CAsyncCallback &callback);
+			void execScanAsync(const std::string &table, const CScan &scan, const CAsyncCallback &callback);
+			void execPutAsync(const std::string &table, const CPut &put, const CAsyncCallback &callback);
+			void execMulitPutAsync(const std::string &table, const CMulitPut &mulit_put, const CAsyncCallback &callback);
+			static std::vector<CAsyncResult> waitAll(std::vector<std::future<CAsyncResult>> &futures);	// һηͳһȴ
+		private:
+			typedef std::function<CAsyncResult()> CTask;
+
+			CTask makeGet(const std::string &table, const CGet &get);
+			CTask makeMulitGet(const std::string &table, const CMulitGet &mulit_get);
+			CTask makeScan(const std::string &table, const CScan &scan);
+			CTask makePut(const std::string &table, const CPut &put);
+			CTask makeMulitPut(const std::string &table, const CMulitPut &mulit_put);
+			std::future<CAsyncResult> submit(const CTask &task);
+			void submit(const CTask &task, const CAsyncCallback &callback);
+			bool post(std::function<void()> &&job);
+			template<class SharedCall, class QueryCall>
+			CAsyncResult execute(SharedCall shared_call, QueryCall query_call);
+			void worker();
+
+			CHBaseThrift														&m_thrift;
+			std::unique_ptr<threadsafe_bounded_queue<std::function<void()>>>	m_jobs;
+			std::vector<std::thread>											m_workers;
+		};
+	}
+}
@@ -0,0 +1,297 @@
+#include <limits>
+#include "bufferedmutator.h"
+#include "log.h"
+
+namespace hbase {
+	namespace thrift2 {
+
+		CBufferedMutator::CBufferedMutator(CHBaseThrift &thrift) :m_thrift(thrift), m_flushCount(1000), m_flushBytes(2 * 1024 * 1024),
+			m_maxBufferBytes(16 * 1024 * 1024), m_linger(100), m_regionAware(false), m_acquireTimeout(3000), m_closed(true), m_nextBatchId(0), m_bufferedBytes(0), m_failed(0)
+		{
+			m_pending.id = 0;
+			m_pending.bytes = 0;
+			m_pending.count = 0;
+		}
+
+		CBufferedMutator::~CBufferedMutator()
+		{
+			close();
+		}
+
+		void CBufferedMutator::setFlushSize(const size_t &count, const size_t &bytes)
+		{
+			m_flushCount = count > 0 ? count : 1;
+			m_flushBytes = bytes;
+		}
+
+		void CBufferedMutator::setMaxBufferSize(const size_t &bytes)
+		{
+			m_maxBufferBytes = bytes;
+		}
+
+		void CBufferedMutator::setLinger(const int &milliseconds)
+		{
+			m_linger = std::chrono::milliseconds(milliseconds);
+		}
+
+		void CBufferedMutator::setRegionAware(const bool &enable)
+		{
+			m_regionAware = enable;
+		}
+
+		void CBufferedMutator::setAcquireTimeout(const int &timeout)
+		{
+			m_acquireTimeout = timeout;
+		}
+
+		bool CBufferedMutator::open(const std::string &table, int threads)
+		{
+			close();
+			m_table = table;
+			m_closed = false;
+			m_lastRegions.reset();
+			for (int i = 0; i < (threads > 0 ? threads : 1); ++i)
+			{
+				m_queues.emplace_back(new CPartQueue(std::numeric_limits<size_t>::max()));	// ѹ m_maxBufferBytes 
+			}
+			for (size_t i = 0; i < m_queues.size(); ++i)
+			{
+				m_workers.emplace_back(&CBufferedMutator::writeWorker, this, i);
+			}
+			m_dispatcher = std::thread(&CBufferedMutator::dispatchWorker, this);
+			return true;
+		}
+
+		void CBufferedMutator::close()
+		{
+			{
+				std::lock_guard<std::mutex> lk(m_mutex);
+				m_closed = true;
+				m_readyCond.notify_all();
+				m_doneCond.notify_all();
+			}
+			if (m_dispatcher.joinable()) m_dispatcher.join();	// ַʣ໺رոд̵߳Ķ
+			for (auto &worker : m_workers) worker.join();		// д߳дʣĲֺ˳
+			m_workers.clear();
+			m_queues.clear();
+		}
+
+		bool CBufferedMutator::mutate(CPut &put)
+		{
+			return append(estimateSize(put), [&put](CBatch &batch) { lastRun(batch.runs, false).puts.appendPut(put); });
+		}
+
+		bool CBufferedMutator::mutate(CDelete &del)
+		{
+			return append(estimateSize(del), [&del](CBatch &batch) { lastRun(batch.runs, true).deletes.appendDelete(del); });
+		}
+
+		bool CBufferedMutator::append(size_t bytes, const std::function<void(CBatch &)> &add)
+		{
+			std::unique_lock<std::mutex> lk(m_mutex);
+			m_doneCond.wait(lk, [this] { return m_closed || m_bufferedBytes < m_maxBufferBytes; });	// ѹ
+			if (m_closed) return false;
+			if (m_pending.empty()) m_pendingSince = std::chrono::steady_clock::now();
+			add(m_pending);
+			m_pending.count++;
+			m_pending.bytes += bytes;
+			m_bufferedBytes += bytes;
+			if (m_pending.size() >= m_flushCount || m_pending.bytes >= m_flushBytes) cutBatch();
+			return true;
+		}
+
+		bool CBufferedMutator::flush()
+		{
+			std::unique_lock<std::mutex> lk(m_mutex);
+			uint64_t failed = m_failed;
+			cutBatch();
+			uint64_t target = m_nextBatchId;	// id С target ζǵǰύ
+			m_doneCond.wait(lk, [this, target] {
+				return (m_ready.empty() || m_ready.front().id >= target) && (m_inflight.empty() || m_inflight.begin()->first >= target);
+			});
+			return failed == m_failed;
+		}
+
+		size_t CBufferedMutator::estimateSize(const CPut &put)
+		{
+			size_t bytes = put.m_put.row.size();
+			for (const apache::hadoop::hbase::thrift2::TColumnValue &column : put.m_familys)
+			{
+				bytes += column.family.size() + column.qualifier.size() + column.value.size() + 16;
+			}
+			return bytes;
+		}
+
+		size_t CBufferedMutator::estimateSize(const CDelete &del)
+		{
+			size_t bytes = del.m_delete.row.size() + 16;
+			for (const apache::hadoop::hbase::thrift2::TColumn &column : del.m_familys)
+			{
+				bytes += column.family.size() + column.qualifier.size() + 16;
+			}
+			return bytes;
+		}
+
+		CBufferedMutator::CRun &CBufferedMutator::lastRun(std::deque<CRun> &runs, bool is_delete)
+		{
+			if (runs.empty() || runs.back().is_delete != is_delete)
+			{
+				runs.emplace_back();
+				runs.back().is_delete = is_delete;
+			}
+			return runs.back();
+		}
+
+		void CBufferedMutator::cutBatch()
+		{
+			if (m_pending.empty()) return;
+			m_ready.emplace_back();
+			CBatch &batch = m_ready.back();
+			batch.id = m_nextBatchId++;
+			batch.bytes = m_pending.bytes;
+			batch.count = m_pending.count;
+			batch.runs.swap(m_pending.runs);
+			m_pending.bytes = 0;
+			m_pending.count = 0;
+			m_readyCond.notify_one();
+		}
+
+		void CBufferedMutator::dispatchWorker()	// Ψһķַ̣߳ id ˳
+		{
+			std::unique_lock<std::mutex> lk(m_mutex);
+			for (;;)
+			{
+				if (m_ready.empty())
+				{
+					if (!m_pending.empty())
+					{
+						std::chrono::steady_clock::time_point deadline = m_pendingSince + m_linger;
+						if (m_closed || std::chrono::steady_clock::now() >= deadline) cutBatch();
+						else m_readyCond.wait_until(lk, deadline);
+					}
+					else if (m_closed) break;
+					else m_readyCond.wait(lk);
+					continue;
+				}
+
+				CBatch batch = std::move(m_ready.front());
+				m_ready.pop_front();
+				CInflight inflight = { 0, batch.bytes };
+				m_inflight[batch.id] = inflight;
+				lk.unlock();
+				dispatchBatch(batch);
+				lk.lock();
+			}
+			lk.unlock();
+			for (auto &queue : m_queues) queue->close();
+		}
+
+		void CBufferedMutator::dispatchBatch(CBatch &batch)	//  region() CPartÿڱύ˳
+		{
+			std::shared_ptr<const CRegionLocator::CRegionMap> regions = m_regionAware ? m_thrift.getRegionLocator().getRegions(m_table) : nullptr;
+			if (regions && regions->size() <= 1) regions.reset();		// ֻһ region ʱзָд߳
+			if (regions != m_lastRegions)		// region ֱˣͬһпܻд̣߳ȵ֮ǰд
+			{
+				std::unique_lock<std::mutex> lk(m_mutex);
+				m_doneCond.wait(lk, [this, &batch] { return m_inflight.begin()->first == batch.id; });
+				m_lastRegions = regions;
+			}
+
+			std::hash<std::string> hasher;
+			std::map<std::pair<size_t, std::string>, CPart> parts;	// (д߳, region startKey) -> д
+			auto partOf = [&](const std::string &row) -> CPart & {
+				std::string start_key = regions ? locate(regions, row) : std::string();
+				size_t worker = (regions ? hasher(start_key) : hasher(row)) % m_queues.size();
+				CPart &part = parts[std::make_pair(worker, start_key)];
+				if (part.row.empty()) part.row = row;
+				return part;
+			};
+			for (CRun &run : batch.runs)
+			{
+				for (apache::hadoop::hbase::thrift2::TPut &put : run.puts.m_puts)
+				{
+					CPart &part = partOf(put.row);
+					lastRun(part.runs, false).puts.m_puts.push_back(std::move(put));
+				}
+				for (apache::hadoop::hbase::thrift2::TDelete &del : run.deletes.m_deletes)
+				{
+					CPart &part = partOf(del.row);
+					lastRun(part.runs, true).deletes.m_deletes.push_back(std::move(del));
+				}
+			}
+
+			{
+				std::lock_guard<std::mutex> lk(m_mutex);
+				m_inflight[batch.id].parts = parts.size() + 1;		// ռһȫӺͷţǰ
+			}
+			for (auto &iter : parts)
+			{
+				iter.second.batch_id = batch.id;
+				m_queues[iter.first.first]->push(std::move(iter.second));
+			}
+			finishPart(batch.id);
+		}
+
+		void CBufferedMutator::writeWorker(size_t index)	// Ƚȳͬһ region ĸ˳д
+		{
+			CPart part;
+			while (m_queues[index]->pop(part))
+			{
+				writePart(part);
+				finishPart(part.batch_id);
+			}
+		}
+
+		void CBufferedMutator::finishPart(uint64_t batch_id)
+		{
+			std::lock_guard<std::mutex> lk(m_mutex);
+			std::map<uint64_t, CInflight>::iterator iter = m_inflight.find(batch_id);
+			if (iter == m_inflight.end() || --iter->second.parts > 0) return;
+			m_bufferedBytes -= iter->second.bytes;
+			m_inflight.erase(iter);
+			m_doneCond.notify_all();
+		}
+
+		std::string CBufferedMutator::locate(const std::shared_ptr<const CRegionLocator::CRegionMap> &regions, const std::string &row)
+		{
+			const THRegionLocation *region = CRegionLocator::findRegion(*regions, row);
+			if (region) return region->regionInfo.startKey;
+			THRegionLocation location;
+			if (m_thrift.getRegionLocator().locate(m_table, row, location)) return location.regionInfo.startKey;
+			return std::string();
+		}
+
+		bool CBufferedMutator::writePart(CPart &part)	// д룬ĳʧܺĶβдύЧ
+		{
+			CHBaseQuery *query = NULL;
+			for (int i = 0; i < 3 && !query; ++i)		// ӳæʱŶӵȴֱӶ
+			{
+				query = m_thrift.getQuery(m_acquireTimeout);
+			}
+			size_t done = 0;
+			HBaseError error = HBASE_OK;
+			uint64_t failed = 0;
+			if (query)
+			{
+				for (; done < part.runs.size(); ++done)
+				{
+					CRun &run = part.runs[done];
+					CMulitDelete rest;
+					bool ret = run.is_delete ? query->execMulitDelete(m_table, run.deletes, &rest) : query->execMulitPut(m_table, run.puts);
+					if (ret) continue;
+					error = query->getLastError();
+					failed += run.is_delete && !rest.empty() ? rest.size() : run.size();
+					++done;
+					break;
+				}
+				m_thrift.releaseQuery(query, query->getConnection()->is_connected());
+			}
+			for (size_t i = done; i < part.runs.size(); ++i) failed += part.runs[i].size();
+			if (failed == 0) return true;
+			m_failed += failed;
+			LERROR("buffered mutator write {} mutations to {} failed", failed, m_table.c_str());
+			if (m_regionAware) m_thrift.getRegionLocator().invalidate(m_table, error, part.row);	// region Ǩƻ
+			return false;
+		}
+	}
+}
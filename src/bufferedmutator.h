@@ -0,0 +1,106 @@
+#pragma once
+#include <map>
+#include <deque>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <condition_variable>
+#include "regionlocator.h"
+
+namespace hbase {
+	namespace thrift2 {
+
+		// 첽д̵߳ mutate ۻ put/deleteﵽ/ֵֽ򳬹 linger ʱɺ̨߳ͨ putMultiple/deleteMultiple д
+		// һڰύ˳г put Ρdelete д룻һַ̰߳˳֣ͬһ region(δ setRegionAware ʱͬһ)
+		// ̶ͬһд̣߳ͬһед벻д߳ open  threadsӦӳشС
+		// ̰߳ȫ
+		class CBufferedMutator
+		{
+		public:
+			explicit CBufferedMutator(CHBaseThrift &thrift);
+			~CBufferedMutator();
+
+			void setFlushSize(const size_t &count = 1000, const size_t &bytes = 2 * 1024 * 1024);	// ֵֽ
+			void setMaxBufferSize(const size_t &bytes = 16 * 1024 * 1024);						// ޣ mutate 
+			void setLinger(const int &milliseconds = 100);										// put ڻͣʱ
+			void setRegionAware(const bool &enable = true);
+			void setAcquireTimeout(const int &timeout = 3000);									// д߳ȡʱÿŶӵĺȡʧ
+			bool open(const std::string &table, int threads = 2);
+			void close();								// дл˳
+			bool mutate(CPut &put);						// ʱѹرշ false
+			bool mutate(CDelete &del);
+			bool flush();								// ȴǰύ put ȫд꣬ڼʧܷ false
+			uint64_t getFailedCount() const { return m_failed; }
+		private:
+			struct CRun		// ͬһ͵д
+			{
+				bool			is_delete;
+				CMulitPut		puts;
+				CMulitDelete	deletes;
+				size_t size() const { return puts.size() + deletes.size(); }
+			};
+
+			struct CBatch
+			{
+				uint64_t			id;
+				size_t				bytes;
+				size_t				count;
+				std::deque<CRun>	runs;			// ύ˳
+				size_t size() const { return count; }
+				bool empty() const { return count == 0; }
+			};
+
+			struct CPart	// һнͬһд̵߳һд룬 setRegionAware ʱͬһ region
+			{
+				uint64_t			batch_id;
+				std::string			row;			// һУʧʱλ region
+				std::deque<CRun>	runs;
+			};
+
+			struct CInflight
+			{
+				size_t		parts;					// ûд CPart 
+				size_t		bytes;
+			};
+
+			typedef threadsafe_bounded_queue<CPart>		CPartQueue;
+
+			static CRun &lastRun(std::deque<CRun> &runs, bool is_delete);	// ͱ仯ʱʼµһ
+			static size_t estimateSize(const CPut &put);
+			static size_t estimateSize(const CDelete &del);
+			bool append(size_t bytes, const std::function<void(CBatch &)> &add);
+			void cutBatch();							// ÷ m_mutex
+			void dispatchWorker();
+			void dispatchBatch(CBatch &batch);
+			void writeWorker(size_t index);
+			bool writePart(CPart &part);
+			void finishPart(uint64_t batch_id);
+			std::string locate(const std::shared_ptr<const CRegionLocator::CRegionMap> &regions, const std::string &row);
+
+			CHBaseThrift										&m_thrift;
+			std::string											m_table;
+			size_t												m_flushCount;
+			size_t												m_flushBytes;
+			size_t												m_maxBufferBytes;
+			std::chrono::milliseconds							m_linger;
+			bool												m_regionAware;
+			int													m_acquireTimeout;
+
+			std::mutex											m_mutex;
+			std::condition_variable								m_readyCond;		// ддλر
+			std::condition_variable								m_doneCond;			// д꣬ mutate/flush/ַ߳
+			bool												m_closed;
+			CBatch												m_pending;			// ۻ
+			std::chrono::steady_clock::time_point				m_pendingSince;
+			std::deque<CBatch>									m_ready;			// кôдΣid 
+			std::map<uint64_t, CInflight>						m_inflight;			// ȡûд
+			uint64_t											m_nextBatchId;
+			size_t												m_bufferedBytes;	// ۻ + д + дֽ
+			std::atomic<uint64_t>								m_failed;			// дʧܵ
+			std::shared_ptr<const CRegionLocator::CRegionMap>	m_lastRegions;		// һõ region գֻɷ̷ַ߳
+			std::thread											m_dispatcher;
+			std::vector<std::unique_ptr<CPartQueue>>			m_queues;			// ÿд߳һ
+			std::vector<std::thread>							m_workers;
+		};
+	}
+}
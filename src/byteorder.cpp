@@ -0,0 +1,133 @@
+#include <string.h>
+#include "byteorder.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HBASE_BYTEORDER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace hbase {
+	namespace thrift2 {
+
+		static void decodeScalar(const char *src, size_t count, uint64_t *dst)
+		{
+			for (size_t i = 0; i < count; ++i) dst[i] = loadBigEndian64(src + i * 8);
+		}
+
+#ifdef HBASE_BYTEORDER_X86
+		__attribute__((target("ssse3")))
+		static void decodeSSSE3(const char *src, size_t count, uint64_t *dst)	// ÿ 2 ֵ
+		{
+			const __m128i mask = _mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+			size_t i = 0;
+			for (; i + 2 <= count; i += 2)
+			{
+				__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 8));
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_shuffle_epi8(v, mask));
+			}
+			decodeScalar(src + i * 8, count - i, dst + i);
+		}
+
+		__attribute__((target("avx2")))
+		static void decodeAVX2(const char *src, size_t count, uint64_t *dst)	// ÿ 8 ֵ·ڸ load ӳ
+		{
+			const __m256i mask = _mm256_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7,
+				8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+			size_t i = 0;
+			for (; i + 8 <= count; i += 8)
+			{
+				__m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * 8));
+				__m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * 8 + 32));
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_shuffle_epi8(v0, mask));
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 4), _mm256_shuffle_epi8(v1, mask));
+			}
+			for (; i + 4 <= count; i += 4)
+			{
+				__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * 8));
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_shuffle_epi8(v, mask));
+			}
+			decodeScalar(src + i * 8, count - i, dst + i);
+		}
+#endif
+
+		static ByteOrderKernel detectKernel()
+		{
+#ifdef HBASE_BYTEORDER_X86
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx2")) return BYTEORDER_AVX2;
+			if (__builtin_cpu_supports("ssse3")) return BYTEORDER_SSSE3;
+#endif
+			return BYTEORDER_SCALAR;
+		}
+
+		ByteOrderKernel getByteOrderKernel()
+		{
+			static const ByteOrderKernel kernel = detectKernel();
+			return kernel;
+		}
+
+		void decodeBigEndian64(ByteOrderKernel kernel, const char *src, size_t count, uint64_t *dst)
+		{
+			if (kernel > getByteOrderKernel()) kernel = getByteOrderKernel();
+			switch (kernel)
+			{
+#ifdef HBASE_BYTEORDER_X86
+			case BYTEORDER_AVX2:
+				decodeAVX2(src, count, dst);
+				break;
+			case BYTEORDER_SSSE3:
+				decodeSSSE3(src, count, dst);
+				break;
+#endif
+			default:
+				decodeScalar(src, count, dst);
+				break;
+			}
+		}
+
+		void decodeBigEndian64(const char *src, size_t count, uint64_t *dst)
+		{
+			decodeBigEndian64(getByteOrderKernel(), src, count, dst);
+		}
+
+		void decodeInt64(const char *src, size_t count, int64_t *dst)
+		{
+			decodeBigEndian64(src, count, reinterpret_cast<uint64_t *>(dst));
+		}
+
+		void decodeDouble(const char *src, size_t count, double *dst)	// ֶν⵽ջٰλ double/uint64_t 
+		{
+			static_assert(sizeof(double) == sizeof(uint64_t), "double must be 64 bits");
+			uint64_t bits[256];
+			for (size_t i = 0; i < count; i += 256)
+			{
+				size_t n = count - i < 256 ? count - i : 256;
+				decodeBigEndian64(src + i * 8, n, bits);
+				memcpy(dst + i, bits, n * sizeof(double));
+			}
+		}
+
+		bool decodeInt64(const std::vector<apache::hadoop::hbase::thrift2::TColumnValue> &columns, std::vector<int64_t> &out)	// ֵɢڸԵ string ת
+		{
+			out.resize(columns.size());
+			for (size_t i = 0; i < columns.size(); ++i)
+			{
+				if (columns[i].value.size() != sizeof(int64_t)) return false;
+				out[i] = static_cast<int64_t>(loadBigEndian64(columns[i].value.data()));
+			}
+			return true;
+		}
+
+		bool decodeDouble(const std::vector<apache::hadoop::hbase::thrift2::TColumnValue> &columns, std::vector<double> &out)
+		{
+			out.resize(columns.size());
+			for (size_t i = 0; i < columns.size(); ++i)
+			{
+				if (columns[i].value.size() != sizeof(double)) return false;
+				uint64_t bits = loadBigEndian64(columns[i].value.data());
+				memcpy(&out[i], &bits, sizeof(double));
+			}
+			return true;
+		}
+	}
+}
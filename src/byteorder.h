@@ -0,0 +1,35 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "hbase/Hbase_types.h"
+
+namespace hbase {
+	namespace thrift2 {
+
+		// HBase Bytes.toBytes(long/double) д 8 ֽڴֵתɱֽ
+		// x86 ״εʱ CPU ѡ AVX2/SSSE3 ֽʵ֣ƽ̨ CPU ñʵ
+		enum ByteOrderKernel
+		{
+			BYTEORDER_SCALAR = 0,
+			BYTEORDER_SSSE3,
+			BYTEORDER_AVX2,
+		};
+
+		inline uint64_t loadBigEndian64(const char *p)	// ֵԲ룬ϳΪһ load + bswap
+		{
+			const unsigned char *b = reinterpret_cast<const unsigned char *>(p);
+			return (uint64_t(b[0]) << 56) | (uint64_t(b[1]) << 48) | (uint64_t(b[2]) << 40) | (uint64_t(b[3]) << 32) |
+				(uint64_t(b[4]) << 24) | (uint64_t(b[5]) << 16) | (uint64_t(b[6]) << 8) | uint64_t(b[7]);
+		}
+
+		void decodeBigEndian64(const char *src, size_t count, uint64_t *dst);		// src Ϊ count ŵ 8 ֵֽԲ
+		void decodeInt64(const char *src, size_t count, int64_t *dst);
+		void decodeDouble(const char *src, size_t count, double *dst);
+		bool decodeInt64(const std::vector<apache::hadoop::hbase::thrift2::TColumnValue> &columns, std::vector<int64_t> &out);	// ֵ 8 ֽʱ false
+		bool decodeDouble(const std::vector<apache::hadoop::hbase::thrift2::TColumnValue> &columns, std::vector<double> &out);
+
+		ByteOrderKernel getByteOrderKernel();									// ǰѡеʵ
+		void decodeBigEndian64(ByteOrderKernel kernel, const char *src, size_t count, uint64_t *dst);	// ָʵ֣Ժͻ׼ԱȣCPU ֧ʱ˻ر
+	}
+}
@@ -0,0 +1,132 @@
+#include "columnarbatch.h"
+#include "byteorder.h"
+
+namespace hbase {
+	namespace thrift2 {
+
+		CColumnarBatch::CColumnarBatch() :m_width(0), m_mixedWidth(false)
+		{
+			clear();
+		}
+
+		void CColumnarBatch::clear()
+		{
+			m_rowOffsets.assign(1, 0);
+			m_rowkeys.clear();
+			m_rowkeyOffsets.assign(1, 0);
+			m_columnIds.clear();
+			m_timestamps.clear();
+			m_values.clear();
+			m_valueOffsets.assign(1, 0);
+			m_width = 0;
+			m_mixedWidth = false;
+		}
+
+		void CColumnarBatch::reset()
+		{
+			clear();
+			m_columns.clear();
+		}
+
+		void CColumnarBatch::append(CResultBatch &batch)
+		{
+			uint32_t column = 0;
+			for (size_t r = batch.m_nextRow; r < batch.m_rows.size(); ++r)
+			{
+				const CResultBatch::CRow &row = batch.m_rows[r];
+				m_rowkeys.append(row.row.data(), row.row.size());
+				m_rowkeyOffsets.push_back(static_cast<uint32_t>(m_rowkeys.size()));
+				for (uint32_t c = row.cell_begin; c < row.cell_end; ++c)
+				{
+					const CCell &cell = batch.m_cells[c];
+					column = findOrAddColumn(cell.family, cell.qualifier, column);
+					if (m_columnIds.empty()) m_width = cell.value.size();
+					else if (cell.value.size() != m_width) m_mixedWidth = true;
+					m_columnIds.push_back(column);
+					m_timestamps.push_back(cell.timestamp);
+					m_values.append(cell.value.data(), cell.value.size());
+					m_valueOffsets.push_back(static_cast<uint32_t>(m_values.size()));
+				}
+				m_rowOffsets.push_back(static_cast<uint32_t>(m_columnIds.size()));
+			}
+			batch.m_nextRow = batch.m_rows.size();
+		}
+
+		uint32_t CColumnarBatch::findOrAddColumn(const CStringView &family, const CStringView &qualifier, uint32_t hint)	// ˳ͨͬһеһ
+		{
+			size_t size = m_columns.size();
+			for (size_t i = 0; i < size; ++i)
+			{
+				uint32_t id = static_cast<uint32_t>((hint + 1 + i) % size);
+				if (family == m_columns[id].first && qualifier == m_columns[id].second) return id;
+			}
+			m_columns.emplace_back(family.to_string(), qualifier.to_string());
+			return static_cast<uint32_t>(size);
+		}
+
+		int CColumnarBatch::findColumn(const CStringView &family, const CStringView &qualifier) const
+		{
+			for (size_t i = 0; i < m_columns.size(); ++i)
+			{
+				if (family == m_columns[i].first && qualifier == m_columns[i].second) return static_cast<int>(i);
+			}
+			return -1;
+		}
+
+		CStringView CColumnarBatch::getRowkey(size_t row) const
+		{
+			return CStringView(m_rowkeys.data() + m_rowkeyOffsets[row], m_rowkeyOffsets[row + 1] - m_rowkeyOffsets[row]);
+		}
+
+		CStringView CColumnarBatch::getValue(size_t cell) const
+		{
+			return CStringView(m_values.data() + m_valueOffsets[cell], m_valueOffsets[cell + 1] - m_valueOffsets[cell]);
+		}
+
+		bool CColumnarBatch::getInt64(std::vector<int64_t> &out) const
+		{
+			out.resize(cells());
+			if (empty()) return true;
+			if (fixedWidth() != sizeof(int64_t)) return false;
+			decodeInt64(m_values.data(), out.size(), out.data());
+			return true;
+		}
+
+		bool CColumnarBatch::getDouble(std::vector<double> &out) const
+		{
+			out.resize(cells());
+			if (empty()) return true;
+			if (fixedWidth() != sizeof(double)) return false;
+			decodeDouble(m_values.data(), out.size(), out.data());
+			return true;
+		}
+
+		int64_t CColumnarBatch::sumInt64(uint32_t column) const
+		{
+			int64_t sum = 0;
+			const char *values = m_values.data();
+			if (fixedWidth() == sizeof(int64_t))	// ȿʱƫƣѭûз֧
+			{
+				for (size_t i = 0; i < m_columnIds.size(); ++i)
+				{
+					int64_t value = static_cast<int64_t>(loadBigEndian64(values + i * sizeof(int64_t)));
+					sum += m_columnIds[i] == column ? value : 0;
+				}
+				return sum;
+			}
+			for (size_t i = 0; i < m_columnIds.size(); ++i)
+			{
+				if (m_columnIds[i] != column || m_valueOffsets[i + 1] - m_valueOffsets[i] != sizeof(int64_t)) continue;
+				sum += static_cast<int64_t>(loadBigEndian64(values + m_valueOffsets[i]));
+			}
+			return sum;
+		}
+
+		size_t CColumnarBatch::count(uint32_t column) const
+		{
+			size_t n = 0;
+			for (size_t i = 0; i < m_columnIds.size(); ++i) n += m_columnIds[i] == column;
+			return n;
+		}
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "resultbatch.h"
+
+namespace hbase {
+	namespace thrift2 {
+
+		// ʽۺͳưαα
+		//  i еΪ [rowOffsets()[i], rowOffsets()[i + 1]) j еֵΪ values() + valueOffsets()[j]ȵ valueOffsets()[j + 1]
+		// family:qualifier  idֵ clear ֮䱣ͬһɨĸ id һ
+		class CColumnarBatch
+		{
+		public:
+			CColumnarBatch();
+
+			void clear();														// ݣֵ
+			void reset();														// ֵͬһ
+			void append(CResultBatch &batch);									// ת batch лû nextRow УǱΪѶ
+			size_t rows() const { return m_rowOffsets.size() - 1; }
+			size_t cells() const { return m_columnIds.size(); }
+			bool empty() const { return m_columnIds.empty(); }
+
+			const uint32_t *rowOffsets() const { return m_rowOffsets.data(); }	// rows() + 1 
+			const uint32_t *columnIds() const { return m_columnIds.data(); }
+			const int64_t *timestamps() const { return m_timestamps.data(); }
+			const char *values() const { return m_values.data(); }
+			const uint32_t *valueOffsets() const { return m_valueOffsets.data(); }	// cells() + 1 
+			CStringView getRowkey(size_t row) const;
+			CStringView getValue(size_t cell) const;
+
+			size_t columnCount() const { return m_columns.size(); }
+			int findColumn(const CStringView &family, const CStringView &qualifier) const;	// ڷ -1
+			CStringView getFamilyName(uint32_t column) const { return m_columns[column].first; }
+			CStringView getColumnName(uint32_t column) const { return m_columns[column].second; }
+
+			size_t fixedWidth() const { return m_mixedWidth ? 0 : m_width; }	// ֵȿʱؿȣ 0
+			bool getInt64(std::vector<int64_t> &out) const;						// ֵ 8 ֽڴ(HBase Bytes.toBytes(long))ʱ SIMD 
+			bool getDouble(std::vector<double> &out) const;
+			int64_t sumInt64(uint32_t column) const;							//  8 ֵֽ֮ͣȵֵ
+			size_t count(uint32_t column) const;
+		private:
+			uint32_t findOrAddColumn(const CStringView &family, const CStringView &qualifier, uint32_t hint);
+
+			std::vector<uint32_t>								m_rowOffsets;
+			std::string											m_rowkeys;
+			std::vector<uint32_t>								m_rowkeyOffsets;
+			std::vector<uint32_t>								m_columnIds;
+			std::vector<int64_t>								m_timestamps;
+			std::string											m_values;
+			std::vector<uint32_t>								m_valueOffsets;
+			size_t												m_width;
+			bool												m_mixedWidth;
+			std::vector<std::pair<std::string, std::string>>	m_columns;		//  id -> (family, qualifier)
+		};
+	}
+}
@@ -1,11 +1,15 @@
 #pragma once
 #include <list>
+#include <deque>
 #include <mutex>
+#include <condition_variable>
 #include <memory>
 #include <vector>
 #include <unordered_map>
 #include <utility>
 #include <atomic>
+#include <algorithm>
+#include <thread>
 #include "boost/thread/mutex.hpp"
 #include "boost/thread/lock_guard.hpp"
 #include "boost/thread/shared_mutex.hpp"
@@ -335,3 +339,217 @@ public:
 };
 
 
+template<typename T>
+class threadsafe_bounded_queue  // нУʱ push ʱ pop close еȴ
+{
+public:
+	explicit threadsafe_bounded_queue(size_t capacity) :m_capacity(capacity ? capacity : 1), m_closed(false)
+	{}
+
+	threadsafe_bounded_queue(threadsafe_bounded_queue const& other) = delete;
+	threadsafe_bounded_queue& operator=(threadsafe_bounded_queue const& other) = delete;
+
+	bool push(T value)	// ѹرշ false
+	{
+		std::unique_lock<std::mutex> lk(m_mutex);
+		m_notFull.wait(lk, [this] { return m_closed || m_data.size() < m_capacity; });
+		if (m_closed) return false;
+		m_data.push_back(std::move(value));
+		m_notEmpty.notify_one();
+		return true;
+	}
+
+	bool pop(T &value)	// ѹرȡշ false
+	{
+		std::unique_lock<std::mutex> lk(m_mutex);
+		m_notEmpty.wait(lk, [this] { return m_closed || !m_data.empty(); });
+		if (m_data.empty()) return false;
+		value = std::move(m_data.front());
+		m_data.pop_front();
+		m_notFull.notify_one();
+		return true;
+	}
+
+	void close()
+	{
+		std::lock_guard<std::mutex> lk(m_mutex);
+		m_closed = true;
+		m_notFull.notify_all();
+		m_notEmpty.notify_all();
+	}
+
+	void clear()
+	{
+		std::lock_guard<std::mutex> lk(m_mutex);
+		m_data.clear();
+		m_notFull.notify_all();
+	}
+private:
+	size_t						m_capacity;
+	bool						m_closed;
+	std::deque<T>				m_data;
+	std::mutex					m_mutex;
+	std::condition_variable		m_notFull;
+	std::condition_variable		m_notEmpty;
+};
+
+
+template<typename T>
+class lockfree_bounded_queue  // н߶߶УλԤ䣬push/pop ڴ棬ȡΪ 2 
+{
+	struct cell
+	{
+		std::atomic<size_t> sequence;
+		T data;
+	};
+public:
+	explicit lockfree_bounded_queue(size_t capacity) :m_enqueuePos(0), m_dequeuePos(0)
+	{
+		size_t size = 2;
+		while (size < capacity) size <<= 1;
+		m_mask = size - 1;
+		m_buffer.reset(new cell[size]);
+		for (size_t i = 0; i < size; ++i)
+		{
+			m_buffer[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	lockfree_bounded_queue(lockfree_bounded_queue const& other) = delete;
+	lockfree_bounded_queue& operator=(lockfree_bounded_queue const& other) = delete;
+
+	bool push(T value)	//  false
+	{
+		cell *c;
+		int spins = 0;
+		size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			c = &m_buffer[pos & m_mask];
+			size_t seq = c->sequence.load(std::memory_order_acquire);
+			intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+			if (diff == 0)	// λУռ
+			{
+				if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+			}
+			else if (diff < 0)	// λûȡߣˣռסûȡ
+			{
+				intptr_t used = static_cast<intptr_t>(pos - m_dequeuePos.load(std::memory_order_acquire));	// pos ѹʱԽʱΪܰ޷űȽ
+				if (used > static_cast<intptr_t>(m_mask)) return false;
+				backoff(spins);
+				pos = m_enqueuePos.load(std::memory_order_relaxed);
+			}
+			else pos = m_enqueuePos.load(std::memory_order_relaxed);
+		}
+		c->data = std::move(value);
+		c->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool pop(T &value)	// пշ false
+	{
+		cell *c;
+		int spins = 0;
+		size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			c = &m_buffer[pos & m_mask];
+			size_t seq = c->sequence.load(std::memory_order_acquire);
+			intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+			if (diff == 0)
+			{
+				if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+			}
+			else if (diff < 0)	// λûĿˣռסûд꣬Ҫдܱ꣬
+			{
+				if (m_enqueuePos.load(std::memory_order_acquire) == pos) return false;
+				backoff(spins);
+				pos = m_dequeuePos.load(std::memory_order_relaxed);
+			}
+			else pos = m_dequeuePos.load(std::memory_order_relaxed);
+		}
+		value = std::move(c->data);
+		c->sequence.store(pos + m_mask + 1, std::memory_order_release);
+		return true;
+	}
+
+	size_t capacity() const { return m_mask + 1; }
+	size_t size() const		// ֵͳ
+	{
+		size_t enqueue = m_enqueuePos.load(std::memory_order_relaxed);
+		size_t dequeue = m_dequeuePos.load(std::memory_order_relaxed);
+		return enqueue > dequeue ? enqueue - dequeue : 0;
+	}
+private:
+	static void backoff(int &spins)	// Էֻһ storeȶδ˵ˣó CPU
+	{
+		if (++spins < 64) std::atomic_signal_fence(std::memory_order_seq_cst);
+		else std::this_thread::yield();
+	}
+
+	std::unique_ptr<cell[]>				m_buffer;
+	size_t								m_mask;
+	char								m_pad0[64];
+	std::atomic<size_t>					m_enqueuePos;		// ߡߵλøռһУα
+	char								m_pad1[64];
+	std::atomic<size_t>					m_dequeuePos;
+	char								m_pad2[64];
+};
+
+class monotonic_arena  // ֻ䲻ͷţreset һԻգַ䣬ѷڴ reset ǰһֱЧ
+{
+public:
+	explicit monotonic_arena(size_t initial = 4096) :m_initial(initial), m_cur(NULL), m_left(0), m_capacity(0) {}
+	monotonic_arena(const monotonic_arena &) = delete;
+	monotonic_arena &operator=(const monotonic_arena &) = delete;
+	monotonic_arena(monotonic_arena &&other) :m_initial(other.m_initial), m_cur(NULL), m_left(0), m_capacity(0) { swap(other); }
+	monotonic_arena &operator=(monotonic_arena &&other)	// ߵһΪ arenaԼʹ
+	{
+		monotonic_arena tmp(std::move(other));
+		swap(tmp);
+		return *this;
+	}
+	void swap(monotonic_arena &other)
+	{
+		std::swap(m_initial, other.m_initial);
+		m_chunks.swap(other.m_chunks);
+		std::swap(m_cur, other.m_cur);
+		std::swap(m_left, other.m_left);
+		std::swap(m_capacity, other.m_capacity);
+	}
+
+	char *allocate(size_t size)
+	{
+		if (size > m_left) grow(size);
+		char *p = m_cur;
+		m_cur += size;
+		m_left -= size;
+		return p;
+	}
+	void reset()	// һ˶ʱϲһ飬ȶÿֲ malloc
+	{
+		if (m_chunks.size() > 1)
+		{
+			m_chunks.clear();
+			m_chunks.emplace_back(new char[m_capacity]);
+		}
+		m_cur = m_chunks.empty() ? NULL : m_chunks.back().get();
+		m_left = m_chunks.empty() ? 0 : m_capacity;
+	}
+	size_t capacity() const { return m_capacity; }
+private:
+	void grow(size_t size)	// ¿ٷп鱣ֲ
+	{
+		size_t chunk = std::max(std::max(m_initial, m_capacity), size);
+		m_chunks.emplace_back(new char[chunk]);
+		m_cur = m_chunks.back().get();
+		m_left = chunk;
+		m_capacity = m_chunks.size() == 1 ? chunk : m_capacity + chunk;
+	}
+
+	size_t								m_initial;
+	std::vector<std::unique_ptr<char[]>> m_chunks;
+	char								*m_cur;
+	size_t								m_left;
+	size_t								m_capacity;	// пܴС
+};
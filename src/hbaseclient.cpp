@@ -1,148 +1,467 @@
 #include <stdlib.h>
+#include <chrono>
+#include <algorithm>
+#include <set>
 #include "hbaseclient.h"
+#include "regionlocator.h"
+#include "columnarbatch.h"
+#include "sharedclient.h"
+#include "metricsserver.h"
 #include "log.h"
 
 #define CATCH(msg) \
 catch (apache::hadoop::hbase::thrift2::TIOError& ex)\
 {\
 	LERROR("{} IOError: {}", msg, ex.message.c_str());\
+	m_lastError = HBASE_IO_ERROR;\
 }\
 catch (apache::thrift::transport::TTransportException& ex)\
 {\
 	LERROR("{} {} transport exception: ({}){}", msg, table.c_str(), ex.getType(), ex.what());\
+	m_lastError = HBASE_TRANSPORT_ERROR;\
 	m_client->reconnect();\
+	if (m_pMetrics) m_pMetrics->addReconnect();\
 }\
 catch (apache::thrift::TApplicationException& ex)\
 {\
 	LERROR("{} {} application exception: ({}){}", msg, table.c_str(), ex.getType(), ex.what());\
+	m_lastError = HBASE_APPLICATION_ERROR;\
 }\
 catch (apache::hadoop::hbase::thrift2::TIllegalArgument& ex)\
 {\
 	LERROR("{} {} exception: {}", msg, table.c_str(), ex.message.c_str());\
+	m_lastError = HBASE_ILLEGAL_ARGUMENT;\
 }\
 catch (apache::thrift::protocol::TProtocolException& ex)\
 {\
 	LERROR("{} {} protocol exception: ({}){}", msg, table.c_str(), ex.getType(), ex.what());\
+	m_lastError = HBASE_PROTOCOL_ERROR;\
 }\
 
 namespace hbase {
 	namespace thrift2 {
 
-		CHBaseConnPool::CHBaseConnPool(const CHBasePrivate &pri):m_private(pri),m_curSize(0), m_maxSize(0)
+		struct CThreadQueryCache	// ÿ߳˽еĲѯ棬߳˳ʱ黹ӳأǼ s_threadCaches ӳάճʱ䲻õ
 		{
+			typedef std::pair<CHBaseQuery *, std::chrono::steady_clock::time_point> CEntry;
 
+			std::mutex						mutex;			// ߳ά֮䣬ƽʱ
+			std::weak_ptr<CHBaseConnPool>	pool;
+			std::vector<CEntry>				queries;		// ĩβ黹
+
+			CThreadQueryCache();
+			~CThreadQueryCache();
+
+			void release(CHBaseQuery *query)
+			{
+				std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> conn = query->getConnection();
+				delete query;
+				std::shared_ptr<CHBaseConnPool> owner = pool.lock();
+				if (owner) owner->ReleaseConnection(conn, conn->is_connected());
+				else conn->close();
+			}
+
+			void trim(size_t keep, std::chrono::milliseconds idle)	// 黹гʱĲѯɵǰ棬÷ mutex
+			{
+				std::chrono::steady_clock::time_point expire = std::chrono::steady_clock::now() - idle;
+				size_t count = 0;
+				while (count < queries.size() && (queries.size() - count > keep || queries[count].second <= expire))
+				{
+					release(queries[count].first);
+					count++;
+				}
+				queries.erase(queries.begin(), queries.begin() + count);
+			}
+
+			void bind(const std::shared_ptr<CHBaseConnPool> &current)	// ӳ open ӣ÷ mutex
+			{
+				if (pool.lock() == current) return;
+				trim(0, std::chrono::milliseconds(0));
+				pool = current;
+			}
+		};
+
+		static std::mutex s_threadCacheMutex;
+		static std::set<CThreadQueryCache *> s_threadCaches;
+		static thread_local CThreadQueryCache t_queryCache;
+
+		CThreadQueryCache::CThreadQueryCache()
+		{
+			std::lock_guard<std::mutex> lk(s_threadCacheMutex);
+			s_threadCaches.insert(this);
 		}
 
-		bool CHBaseConnPool::InitConnpool(int maxSize)
+		CThreadQueryCache::~CThreadQueryCache()
 		{
-			m_maxSize = maxSize;
-			LDEBUG("InitHBaseConnpool {}[{}]", m_private.host_list, maxSize);
-			std::vector<std::string> host_array;
-			StringSplit(host_array, m_private.host_list, ",");
+			{
+				std::lock_guard<std::mutex> lk(s_threadCacheMutex);
+				s_threadCaches.erase(this);
+			}
+			std::lock_guard<std::mutex> lk(mutex);
+			trim(0, std::chrono::milliseconds(0));
+		}
 
-			for (std::vector<std::string>::const_iterator iter = host_array.begin(); iter != host_array.end(); iter++)
+		static void reclaimThreadCaches(CHBaseConnPool *owner, std::chrono::milliseconds idle)	// Ѹ̻߳ ownerг idle Ĳѯ黹ӳ
+		{
+			std::chrono::steady_clock::time_point expire = std::chrono::steady_clock::now() - idle;
+			std::vector<CHBaseQuery *> expired;
 			{
-				std::vector<std::string> ip_port;
-				StringSplit(ip_port, *iter, ":");
-				if (ip_port.size() != 2)
+				std::lock_guard<std::mutex> lk(s_threadCacheMutex);
+				for (CThreadQueryCache *cache : s_threadCaches)
 				{
-					continue;
+					std::lock_guard<std::mutex> cache_lk(cache->mutex);
+					if (cache->pool.lock().get() != owner) continue;
+					size_t count = 0;
+					while (count < cache->queries.size() && cache->queries[count].second <= expire) expired.push_back(cache->queries[count++].first);
+					cache->queries.erase(cache->queries.begin(), cache->queries.begin() + count);
 				}
-				const std::string& host_ip = ip_port[0];
-				const std::string& host_port = ip_port[1];
-				m_servers.push_back(std::make_pair(host_ip, atoi(host_port.c_str())));
 			}
+			for (CHBaseQuery *query : expired)		// 黹ReleaseConnection ܻŶ
+			{
+				std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> conn = query->getConnection();
+				delete query;
+				owner->ReleaseConnection(conn, conn->is_alive());
+			}
+			if (!expired.empty()) LDEBUG("reclaim {} idle queries from thread caches", expired.size());
+		}
+
+		CHBaseConnPool::CHBaseConnPool(const CHBasePrivate &pri, CHBaseMetrics *metrics):m_private(pri),m_curSize(0), m_maxSize(0), m_waiterCount(0),
+			m_shutdown(false), m_acquires(0), m_waits(0), m_timeouts(0), m_waitUsTotal(0), m_waitUsMax(0), m_pMetrics(metrics)
+		{
+
+		}
+
+		bool CHBaseConnPool::InitConnpool(int maxSize)
+		{
+			m_maxSize = maxSize;
+			m_freeConns.reset(new lockfree_bounded_queue<std::shared_ptr<CThriftClientHelper<THBaseServiceClient>>>(maxSize));
+			LDEBUG("InitHBaseConnpool {}[{}]", m_private.host_list, maxSize);
+			parseHostList(m_private.host_list, m_servers);
 
-			for (int i = 0; i < m_maxSize / 2; ++i) // ʼһ
+			for (int i = 0; i < m_maxSize / 2 && reserveSlot(); ++i) // ʼһ
 			{
 				std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> conn = createConnection();
 				if(conn) putFreeConn(conn);
+				else freeSlot();
 			}
 			m_timer.bind(std::bind(&CHBaseConnPool::onTimer, this));
-			m_timer.start(30 * 1000); // 30sec
+			m_timer.start(m_private.keepalive_interval > 0 ? std::max(1000, m_private.keepalive_interval / 2) : 30 * 1000);
 			return true;
 		}
 
-		std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> CHBaseConnPool::GetConnection()
+		std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> CHBaseConnPool::GetConnection(int timeout)
 		{
-			std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> hbaseConn = getFreeConn();
-			if (hbaseConn == NULL && m_curSize < m_maxSize)
+			std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> hbaseConn;
+			if (m_shutdown) return hbaseConn;
+			if (m_waiterCount == 0) hbaseConn = tryConnection();	// Ŷʱ
+			if (hbaseConn)
 			{
-				hbaseConn = createConnection();
+				if (m_pMetrics) m_pMetrics->recordPoolWait(0);
+			}
+			else if (timeout > 0)
+			{
+				hbaseConn = waitConnection(timeout);		// ȴʱ¼
 			}
+			if (hbaseConn) m_acquires++;
+			return hbaseConn;
+		}
+
+		std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> CHBaseConnPool::tryConnection()
+		{
+			std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> hbaseConn;
+			if (m_shutdown) return hbaseConn;		// رպ½
+			hbaseConn = getFreeConn();
 			if (hbaseConn && !hbaseConn->is_connected())
 			{
+				hbaseConn->close();
+				hbaseConn = nullptr;
 				m_curSize--;
+			}
+			if (hbaseConn == NULL && reserveSlot())
+			{
 				hbaseConn = createConnection();
+				if (!hbaseConn) freeSlot();
 			}
 			return hbaseConn;
 		}
 
-		void CHBaseConnPool::DestoryConnPool()
+		std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> CHBaseConnPool::waitConnection(int timeout)
 		{
+			std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+			std::chrono::steady_clock::time_point deadline = begin + std::chrono::milliseconds(timeout);
+			std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> hbaseConn;
+			CWaiter waiter;
+			std::unique_lock<std::mutex> lk(m_waitMutex);
+			m_waiters.push_back(&waiter);
+			m_waiterCount++;
+			m_waits++;
+			if (!m_shutdown) m_freeConns->pop(hbaseConn);	// ǰպӹ黹ж
+			while (!hbaseConn && !m_shutdown)	// DestoryConnPool  m_shutdown ٳնУʱ־һᱻ
+			{
+				waiter.cond.wait_until(lk, deadline, [&waiter] { return waiter.conn || waiter.retry; });
+				if (m_shutdown && !waiter.conn) break;		// ӳѹر
+				if (waiter.conn)
+				{
+					hbaseConn = std::move(waiter.conn);
+				}
+				else if (waiter.retry)
+				{
+					waiter.retry = false;
+					lk.unlock();
+					hbaseConn = tryConnection();
+					lk.lock();
+					if (!hbaseConn && !m_shutdown && std::chrono::steady_clock::now() < deadline) m_waiters.push_front(&waiter);	// ûص
+					else if (!hbaseConn) break;
+				}
+				else break;		// ʱ
+			}
+			std::deque<CWaiter *>::iterator self = std::find(m_waiters.begin(), m_waiters.end(), &waiter);
+			if (self != m_waiters.end()) m_waiters.erase(self);
+			m_waiterCount--;
+			lk.unlock();
+
+			uint64_t wait_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+			m_waitUsTotal += wait_us;
+			uint64_t max_us = m_waitUsMax;
+			while (wait_us > max_us && !m_waitUsMax.compare_exchange_weak(max_us, wait_us));
+			if (m_pMetrics) m_pMetrics->recordPoolWait(wait_us);
+			if (!hbaseConn && !m_shutdown)
+			{
+				m_timeouts++;
+				LWARN("wait hbase connection timeout {}ms, pool size {}", timeout, m_curSize.load());
+			}
+			return hbaseConn;
+		}
+
+		bool CHBaseConnPool::reserveSlot()
+		{
+			int cur = m_curSize;
+			while (cur < m_maxSize)
+			{
+				if (m_curSize.compare_exchange_weak(cur, cur + 1)) return true;
+			}
+			return false;
+		}
+
+		void CHBaseConnPool::freeSlot()
+		{
+			m_curSize--;
+			if (m_waiterCount == 0) return;
+			std::lock_guard<std::mutex> lk(m_waitMutex);
+			if (m_waiters.empty()) return;
+			CWaiter *waiter = m_waiters.front();
+			m_waiters.pop_front();
+			waiter->retry = true;
+			waiter->cond.notify_one();
+		}
+
+		CHBasePoolStats CHBaseConnPool::getStats()
+		{
+			CHBasePoolStats stats;
+			stats.cur_size = m_curSize;
+			stats.idle_size = m_freeConns ? static_cast<int>(m_freeConns->size()) : 0;
+			stats.waiters = m_waiterCount;
+			stats.acquires = m_acquires;
+			stats.waits = m_waits;
+			stats.timeouts = m_timeouts;
+			stats.wait_us_total = m_waitUsTotal;
+			stats.wait_us_max = m_waitUsMax;
+			return stats;
+		}
+
+		void CHBaseConnPool::DestoryConnPool()	// ͣά֮ӹ黹ʱֱӹر
+		{
+			m_shutdown = true;
+			m_timer.stop();
+			{
+				std::lock_guard<std::mutex> lk(m_maintainMutex);
+			}
+			{
+				std::lock_guard<std::mutex> lk(m_waitMutex);	// ȫŶߣ m_shutdown 󷵻ؿ
+				for (CWaiter *waiter : m_waiters)
+				{
+					waiter->retry = true;
+					waiter->cond.notify_one();
+				}
+				m_waiters.clear();
+			}
+			if (m_private.thread_cache_size > 0) reclaimThreadCaches(this, std::chrono::milliseconds(0));	// ̻߳һر
 			std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> hbaseConn;
 			while ((hbaseConn = getFreeConn()) != nullptr)
 			{
 				hbaseConn->close();
+				freeSlot();
 			}
-			m_curSize = 0;
 		}
 
 		void CHBaseConnPool::ReleaseConnection(std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> conn, bool bRelease)
 		{
-			if (bRelease)
+			if (bRelease && !m_shutdown)
 			{
+				if (conn) conn->_last_used = std::chrono::steady_clock::now();
 				putFreeConn(conn);
 			}
 			else if (conn)
 			{
 				conn->close();
-				m_curSize--;
+				freeSlot();
 			}
 		}
 
 		std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> CHBaseConnPool::getFreeConn()
 		{
-			return m_connList.pop_front();
+			std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> conn;
+			if (m_freeConns) m_freeConns->pop(conn);
+			return conn;
+		}
+
+		void CHBaseConnPool::parseHostList(const std::string &lists, std::vector<std::pair<std::string, int>> &servers)
+		{
+			std::vector<std::string> host_array;
+			StringSplit(host_array, lists, ",");
+
+			for (std::vector<std::string>::const_iterator iter = host_array.begin(); iter != host_array.end(); iter++)
+			{
+				std::vector<std::string> ip_port;
+				StringSplit(ip_port, *iter, ":");
+				if (ip_port.size() != 2)
+				{
+					continue;
+				}
+				const std::string& host_ip = ip_port[0];
+				const std::string& host_port = ip_port[1];
+				servers.push_back(std::make_pair(host_ip, atoi(host_port.c_str())));
+			}
 		}
 
 		std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> CHBaseConnPool::createConnection()
 		{	
 			std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> conn = std::make_shared<CThriftClientHelper<THBaseServiceClient>>
-				(m_servers, m_private.connect_timeout, m_private.recive_timeout, m_private.send_timeout);
+				(m_servers, m_private.connect_timeout, m_private.recive_timeout, m_private.send_timeout, 1, 60, 1, true, true,
+				m_private.transport, m_private.protocol);
 			if (!conn->connect())
 			{
 				return nullptr;
 			}
-			m_curSize++;
 			return conn;
 		}
 
 		void CHBaseConnPool::putFreeConn(std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> conn)
 		{
-			m_connList.push_front(conn);
+			if (m_waiterCount > 0)		// Ŷʱֱӽ
+			{
+				std::lock_guard<std::mutex> lk(m_waitMutex);
+				if (!m_waiters.empty())
+				{
+					CWaiter *waiter = m_waiters.front();
+					m_waiters.pop_front();
+					waiter->conn = conn;
+					waiter->cond.notify_one();
+					return;
+				}
+			}
+			if (!m_freeConns || !m_freeConns->push(conn))	// ֱӹر
+			{
+				conn->close();
+				freeSlot();
+				return;
+			}
+			if (m_waiterCount > 0)		// жеͬʱ˿ʼŶ
+			{
+				std::lock_guard<std::mutex> lk(m_waitMutex);
+				if (!m_waiters.empty() && m_freeConns->pop(conn))
+				{
+					CWaiter *waiter = m_waiters.front();
+					m_waiters.pop_front();
+					waiter->conn = conn;
+					waiter->cond.notify_one();
+				}
+			}
 		}
 
-		void CHBaseConnPool::onTimer()
+		void CHBaseConnPool::onTimer()	// ̨ά̽ӡ޳ӡնӡԤȵ min_idle
 		{
 			// hbase thrift2 server ÿһӻϿӣʱֻconf/hbase-site.xml еĳʱʱ(α겻α)
 			// hbase ĳĿģϿӣ취ʹӱִ
-			//LDEBUG("HBaseConnpool ping[{}]:{}", m_curSize.load(), m_private.host_list.c_str());
-		/*	apache::hadoop::hbase::thrift2::TIncrement increment;
-			std::vector<apache::hadoop::hbase::thrift2::TColumnIncrement> family_increment_columns;
-			increment.__set_durability(TDurability::SYNC_WAL);
-			std::string row_key = CDateTime::currentDateTime().ToString3();
-			increment.__set_row(row_key);
-			apache::hadoop::hbase::thrift2::TColumnIncrement  family_column;
-			family_column.__set_family("ping");
-			family_column.__set_qualifier("count");
-			family_column.__set_amount(1);
-			family_increment_columns.push_back(family_column);
-			increment.__set_columns(family_increment_columns);
-			m_connList.for_each([&increment](CThriftClientHelper<THBaseServiceClient> *client) {
-				apache::hadoop::hbase::thrift2::TResult result;
-				(*client)->increment(result, "ping_increment", increment);
-			});*/
+			std::lock_guard<std::mutex> lk(m_maintainMutex);	// DestoryConnPool ˵ȴڽеά
+			if (!m_freeConns || m_shutdown) return;
+			if (m_private.thread_cache_size > 0)	// ̻߳ﳤʱ䲻õȻصһ𱣻
+			{
+				int idle_ms = m_private.thread_cache_idle;
+				if (m_private.keepalive_interval > 0) idle_ms = std::min(idle_ms, m_private.keepalive_interval);
+				reclaimThreadCaches(this, std::chrono::milliseconds(idle_ms));
+			}
+			std::chrono::milliseconds keepalive(m_private.keepalive_interval);
+			std::chrono::milliseconds idle_timeout(m_private.idle_timeout);
+			size_t idle = m_freeConns->size();
+			size_t evicted = 0;
+			std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> conn;
+			for (size_t i = 0; i < idle && !m_shutdown && m_waiterCount == 0 && m_freeConns->pop(conn); ++i)	// һֻȡһŶʱó
+			{
+				std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+				bool expired = m_private.idle_timeout > 0 && now - conn->_last_used >= idle_timeout;
+				if (expired && m_freeConns->size() >= static_cast<size_t>(m_private.min_idle))
+				{
+					conn->close();
+					freeSlot();
+					evicted++;
+					continue;
+				}
+				bool stale = now - std::max(conn->_last_used, conn->_last_check) >= keepalive;
+				if ((m_private.keepalive_interval > 0 && stale && !ping(conn)) || !conn->is_connected())
+				{
+					if (m_pMetrics) m_pMetrics->addReconnect();
+					if (!conn->reconnect())
+					{
+						conn->close();
+						freeSlot();
+						evicted++;
+						continue;
+					}
+				}
+				putFreeConn(conn);		// ŻضβֱӽŶߣٿһ
+			}
+
+			int created = 0;
+			while (!m_shutdown && static_cast<int>(m_freeConns->size()) < m_private.min_idle && reserveSlot())
+			{
+				conn = createConnection();
+				if (!conn)
+				{
+					freeSlot();
+					break;
+				}
+				putFreeConn(conn);
+				created++;
+			}
+			if (evicted || created) LDEBUG("HBaseConnpool maintain[{}]: evicted {}, created {}", m_curSize.load(), evicted, created);
+		}
+
+		bool CHBaseConnPool::ping(const std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> &conn)
+		{
+			if (!conn->is_connected()) return false;
+			if (m_private.ping_table.empty()) return true;
+			apache::hadoop::hbase::thrift2::TGet get;
+			get.__set_row(m_private.ping_row);
+			try
+			{
+				(*conn)->exists(m_private.ping_table, get);
+			}
+			catch (apache::thrift::transport::TTransportException& ex)
+			{
+				LWARN("ping {} transport exception: ({}){}", conn->str().c_str(), ex.getType(), ex.what());
+				return false;
+			}
+			catch (apache::thrift::protocol::TProtocolException& ex)
+			{
+				LWARN("ping {} protocol exception: ({}){}", conn->str().c_str(), ex.getType(), ex.what());
+				return false;
+			}
+			catch (apache::thrift::TException& ex)	// TIOError ˵Ӧӿ
+			{
+			}
+			conn->_last_check = std::chrono::steady_clock::now();
+			return true;
 		}
 
 		///////////////////////////////////////////////////////// CGet ///////////////////////////////////////////////////////////
@@ -176,12 +495,12 @@ namespace hbase {
 			m_get.__set_filterString(buf);
 		}
 
-		void CGet::appendColumn(const std::string &family, const std::string &qualifier)
+		void CGet::appendColumn(const std::string &family, const std::string &qualifier)	// ֱд TGetexec ʱ忽һ
 		{
-			apache::hadoop::hbase::thrift2::TColumn  family_column;
-			family_column.__set_family(family);
-			if (!qualifier.empty()) family_column.__set_qualifier(qualifier);
-			m_familys.push_back(family_column);
+			m_get.columns.emplace_back();
+			m_get.columns.back().__set_family(family);
+			if (!qualifier.empty()) m_get.columns.back().__set_qualifier(qualifier);
+			m_get.__isset.columns = true;
 		}
 
 		void CGet::setTimeRange(const int64_t &begin, const int64_t &end)
@@ -221,8 +540,37 @@ namespace hbase {
 			m_put.__set_durability(durability);
 		}
 
+		////////////////////////////////////////////////// CDelete ////////////////////////////////////////////////////
+		CDelete::CDelete()
+		{
+			m_delete.__set_durability(TDurability::SYNC_WAL);
+		}
+
+		CDelete::~CDelete()
+		{
+
+		}
+
+		void CDelete::setRowkey(const std::string& rowkey)
+		{
+			m_delete.__set_row(rowkey);
+		}
+
+		void CDelete::appendColumn(const std::string &family, const std::string &qualifier)
+		{
+			apache::hadoop::hbase::thrift2::TColumn  family_column;
+			family_column.__set_family(family);
+			if (!qualifier.empty()) family_column.__set_qualifier(qualifier);
+			m_familys.push_back(family_column);
+		}
+
+		void CDelete::setDurability(TDurability::type durability)
+		{
+			m_delete.__set_durability(durability);
+		}
+
 		////////////////////////////////////////////////// CScan ////////////////////////////////////////////////////////
-		CScan::CScan():m_nCacheRows(0)
+		CScan::CScan():m_nCacheRows(0), m_nPrefetch(0)
 		{
 
 		}
@@ -247,6 +595,11 @@ namespace hbase {
 			m_scan.__set_reversed(rev);
 		}
 
+		void CScan::setPrefetch(const int &batches)
+		{
+			m_nPrefetch = batches;
+		}
+
 		void CScan::setMaxVersion(const uint16_t &version)
 		{
 			m_scan.__set_maxVersions(version);
@@ -278,101 +631,436 @@ namespace hbase {
 
 		void CScan::appendColumn(const std::string &family, const std::string &qualifier)
 		{
-			apache::hadoop::hbase::thrift2::TColumn  family_column;
-			family_column.__set_family(family);
-			if(!qualifier.empty()) family_column.__set_qualifier(qualifier);
-			m_familys.push_back(family_column);
+			m_scan.columns.emplace_back();
+			m_scan.columns.back().__set_family(family);
+			if (!qualifier.empty()) m_scan.columns.back().__set_qualifier(qualifier);
+			m_scan.__isset.columns = true;
 		}
 
-		//////////////////////////////////////////////// CHBaseQuery ///////////////////////////////////////////////////
-		CHBaseQuery::CHBaseQuery(std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> client):m_client(client), m_retryTimes(2)
+		//////////////////////////////////////////////// CPipeline ///////////////////////////////////////////////////
+		void CPipeline::clear()
+		{
+			m_ops.clear();
+			m_tables.clear();
+			m_gets.clear();
+			m_puts.clear();
+			m_deletes.clear();
+			m_errors.clear();
+		}
+
+		uint32_t CPipeline::tableIndex(const std::string &table)	// һֻͨ漰һű
+		{
+			for (size_t i = m_tables.size(); i > 0; --i)
+			{
+				if (m_tables[i - 1] == table) return static_cast<uint32_t>(i - 1);
+			}
+			m_tables.push_back(table);
+			return static_cast<uint32_t>(m_tables.size() - 1);
+		}
+
+		void CPipeline::appendGet(const std::string &table, const CGet &get)
+		{
+			COp op = { PIPELINE_GET, tableIndex(table), static_cast<uint32_t>(m_gets.size()) };
+			m_gets.push_back(get.m_get);
+			m_ops.push_back(op);
+		}
+
+		void CPipeline::appendPut(const std::string &table, CPut &put)
+		{
+			COp op = { PIPELINE_PUT, tableIndex(table), static_cast<uint32_t>(m_puts.size()) };
+			put.m_put.__set_columnValues(put.m_familys);
+			m_puts.push_back(put.m_put);
+			m_ops.push_back(op);
+		}
+
+		void CPipeline::appendDelete(const std::string &table, CDelete &del)
 		{
+			COp op = { PIPELINE_DELETE, tableIndex(table), static_cast<uint32_t>(m_deletes.size()) };
+			if (!del.m_familys.empty()) del.m_delete.__set_columns(del.m_familys);
+			m_deletes.push_back(del.m_delete);
+			m_ops.push_back(op);
+		}
 
+		//////////////////////////////////////////////// CHBaseQuery ///////////////////////////////////////////////////
+		CHBaseQuery::CHBaseQuery(std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> client, CHBaseMetrics *metrics):m_client(client), m_retryTimes(2), m_lastError(HBASE_OK),
+			m_scannerId(-1), m_scanBatch(0), m_pMetrics(metrics), m_tableMetrics(NULL)
+		{
 		}
 
 		CHBaseQuery::~CHBaseQuery()
 		{
+			closeScanner();
 			m_result.clear();
 		}
 
+		COpMetrics *CHBaseQuery::tableMetrics(const std::string &table)
+		{
+			if (!m_tableMetrics || table != m_metricsTable) {
+				m_tableMetrics = m_pMetrics->getTable(table);
+				m_metricsTable = table;
+			}
+			return m_tableMetrics;
+		}
+
+		CHBaseQuery::CCallProbe CHBaseQuery::beginCall(HBaseOp op, const std::string &table)
+		{
+			CCallProbe probe = { NULL, std::chrono::steady_clock::time_point(), 0, 0 };
+			if (!m_pMetrics) return probe;
+			probe.metrics = tableMetrics(table) + op;
+			m_pMetrics->beginRequest();
+			probe.begin = std::chrono::steady_clock::now();
+			probe.sent = m_client->bytes_sent();
+			probe.received = m_client->bytes_received();
+			return probe;
+		}
+
+		bool CHBaseQuery::endCall(const CCallProbe &probe, int retry_count, bool ok)	//  ok return endCall(...)
+		{
+			if (!probe.metrics) return ok;
+			m_pMetrics->endRequest();
+			uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - probe.begin).count();
+			probe.metrics->record(us, retry_count, ok, m_client->bytes_sent() - probe.sent, m_client->bytes_received() - probe.received);
+			return ok;
+		}
+
 		bool CHBaseQuery::nextRow()
 		{
-			if (m_result.end() == m_RowIter) return false;
-			m_CloumnIter = m_RowIter->columnValues.begin();
-			m_RowCurrIter = m_RowIter;
-			m_RowIter++;
-			return true;
+			if (m_result.nextRow()) return true;
+			return fetchScannerRows() && m_result.nextRow();
 		}
 
 		bool CHBaseQuery::nextColumn()
 		{
-			if (m_RowCurrIter->columnValues.end() == m_CloumnIter) return false;
-			m_CloumnCurrIter = m_CloumnIter;
-			m_CloumnIter++;
+			return m_result.nextColumn();
+		}
+
+		bool CHBaseQuery::fetchBatch(CResultBatch &batch)
+		{
+			if (!fetchScannerRows()) return false;
+			std::swap(m_result, batch);
+			m_result.clear();
+			return true;
+		}
+
+		bool CHBaseQuery::fetchColumnar(CColumnarBatch &columns)
+		{
+			columns.clear();
+			if (m_result.remaining() == 0 && !fetchScannerRows()) return false;
+			columns.append(m_result);
 			return true;
 		}
 
 		bool CHBaseQuery::execGet(const std::string &table, CGet &get)
 		{
+			closeScanner();
 			m_result.clear();
-			get.m_get.__set_columns(get.m_familys);
+			CCallProbe probe = beginCall(HBASE_OP_GET, table);
 			for (int i = 0; i < m_retryTimes; ++i){
 				try{
-					apache::hadoop::hbase::thrift2::TResult ret;
-					(*m_client)->get(ret, table, get.m_get);
-					m_result.push_back(ret);
-					m_RowIter = m_result.begin();
-					return true;
+					(*m_client)->send_get(table, get.m_get);
+					m_result.recvResult((*m_client)->getInputProtocol().get(), "get");
+					return endCall(probe, i, true);
 				}
 				CATCH("exec get from")
 			}
-			return false;
+			return endCall(probe, m_retryTimes - 1, false);
 		}
 
 		bool  CHBaseQuery::execPut(const std::string &table, CPut &put)
 		{
 			put.m_put.__set_columnValues(put.m_familys);
+			CCallProbe probe = beginCall(HBASE_OP_PUT, table);
 			for (int i = 0; i < m_retryTimes; ++i) {
 				try {
 					(*m_client)->put(table, put.m_put);
-					return true;
+					return endCall(probe, i, true);
 				}
 				CATCH("exec put to")
 			}
-			return false;
+			return endCall(probe, m_retryTimes - 1, false);
+		}
+
+		bool CHBaseQuery::execMulitPut(const std::string &table, CMulitPut &mulit_put)
+		{
+			CCallProbe probe = beginCall(HBASE_OP_MULIT_PUT, table);
+			for (int i = 0; i < m_retryTimes; ++i) {
+				try {
+					(*m_client)->putMultiple(table, mulit_put.m_puts);
+					return endCall(probe, i, true);
+				}
+				CATCH("exec mulit put to")
+			}
+			return endCall(probe, m_retryTimes - 1, false);
+		}
+
+		bool CHBaseQuery::execMulitDelete(const std::string &table, CMulitDelete &mulit_delete, CMulitDelete *failed)
+		{
+			std::vector<apache::hadoop::hbase::thrift2::TDelete> pending;		// ˷δɾУһֻⲿ
+			const std::vector<apache::hadoop::hbase::thrift2::TDelete> *deletes = &mulit_delete.m_deletes;
+			CCallProbe probe = beginCall(HBASE_OP_MULIT_DELETE, table);
+			for (int i = 0; i < m_retryTimes; ++i) {
+				try {
+					std::vector<apache::hadoop::hbase::thrift2::TDelete> rest;
+					(*m_client)->deleteMultiple(rest, table, *deletes);
+					if (rest.empty()) {
+						if (failed) failed->clear();
+						return endCall(probe, i, true);
+					}
+					LERROR("exec mulit delete from {} failed {}/{}", table.c_str(), rest.size(), deletes->size());
+					pending.swap(rest);
+					deletes = &pending;
+					continue;
+				}
+				CATCH("exec mulit delete from")
+			}
+			if (failed) failed->m_deletes = *deletes;
+			return endCall(probe, m_retryTimes - 1, false);
 		}
 
 		bool CHBaseQuery::execMulitGet(const std::string &table, CMulitGet &mulit_get)
 		{
+			closeScanner();
 			m_result.clear();
+			CCallProbe probe = beginCall(HBASE_OP_MULIT_GET, table);
 			for (int i = 0; i < m_retryTimes; ++i) {
 				try {
-					(*m_client)->getMultiple(m_result, table, mulit_get.m_gets);
-					m_RowIter = m_result.begin();
-					return true;
+					(*m_client)->send_getMultiple(table, mulit_get.m_gets);
+					m_result.recvResults((*m_client)->getInputProtocol().get(), "getMultiple");
+					return endCall(probe, i, true);
 				}
 				CATCH("exec mulit get from")
 			}
-			return false;
+			return endCall(probe, m_retryTimes - 1, false);
 		}
 
 		bool CHBaseQuery::execScan(const std::string &table, CScan &scan)
 		{
+			closeScanner();
 			m_result.clear();
-			int32_t caching = scan.m_nCacheRows * scan.m_familys.size();
+			int32_t caching = scan.m_nCacheRows * scan.m_scan.columns.size();
 			scan.m_scan.__set_caching(caching);
-			scan.m_scan.__set_columns(scan.m_familys);
+			CCallProbe probe = beginCall(HBASE_OP_SCAN, table);
 			for (int i = 0; i < m_retryTimes; ++i) {
 				try {
-					(*m_client)->getScannerResults(m_result, table, scan.m_scan, scan.m_nCacheRows);
-					m_RowIter = m_result.begin();
-					return true;
+					(*m_client)->send_getScannerResults(table, scan.m_scan, scan.m_nCacheRows);
+					m_result.recvResults((*m_client)->getInputProtocol().get(), "getScannerResults");
+					return endCall(probe, i, true);
 				}
 				CATCH("exec scan from")
 			}
+			return endCall(probe, m_retryTimes - 1, false);
+		}
+
+		bool CHBaseQuery::execPipeline(CPipeline &pipeline, size_t window)	// ˶ͬһӵӦseqid ƥ
+		{
+			closeScanner();
+			m_result.clear();
+			pipeline.m_errors.assign(pipeline.m_ops.size(), HBASE_OK);
+			if (window == 0) window = 1;		// ;ޣ˫д socket 
+			size_t sent = 0, received = 0;
+			bool ok = true;
+			const std::string &table = pipeline.m_tables.empty() ? m_table : pipeline.m_tables.front();
+			CCallProbe probe = beginCall(HBASE_OP_PIPELINE, table);		// ڵһű
+			try {
+				while (received < pipeline.m_ops.size()) {
+					while (sent < pipeline.m_ops.size() && sent - received < window) sendPipelineOp(pipeline, sent++);
+					HBaseError error = recvPipelineOp(pipeline, received);
+					pipeline.m_errors[received++] = error;
+					if (error != HBASE_OK) {
+						m_lastError = error;
+						ok = false;
+					}
+				}
+				return endCall(probe, 0, ok);
+			}
+			CATCH("exec pipeline on")
+			if (m_lastError == HBASE_PROTOCOL_ERROR) {	// ӦѴλӦ޷ٶ
+				m_client->reconnect();
+				if (m_pMetrics) m_pMetrics->addReconnect();
+			}
+			for (; received < pipeline.m_ops.size(); ++received) {	// Ѷϣʣȫʧ
+				pipeline.m_errors[received] = static_cast<HBaseError>(m_lastError.load());
+				if (pipeline.m_ops[received].type == CPipeline::PIPELINE_GET) m_result.appendEmptyRow();
+			}
+			return endCall(probe, 0, false);
+		}
+
+		void CHBaseQuery::sendPipelineOp(const CPipeline &pipeline, size_t index)
+		{
+			const CPipeline::COp &op = pipeline.m_ops[index];
+			const std::string &table = pipeline.m_tables[op.table];
+			switch (op.type) {
+			case CPipeline::PIPELINE_GET:
+				(*m_client)->send_get(table, pipeline.m_gets[op.index]);
+				break;
+			case CPipeline::PIPELINE_PUT:
+				(*m_client)->send_put(table, pipeline.m_puts[op.index]);
+				break;
+			case CPipeline::PIPELINE_DELETE:
+				(*m_client)->send_deleteSingle(table, pipeline.m_deletes[op.index]);
+				break;
+			}
+		}
+
+		HBaseError CHBaseQuery::recvPipelineOp(const CPipeline &pipeline, size_t index)	// ˷ص쳣ӰӦ/Э׳
+		{
+			const CPipeline::COp &op = pipeline.m_ops[index];
+			const std::string &table = pipeline.m_tables[op.table];
+			HBaseError error = HBASE_OK;
+			try {
+				switch (op.type) {
+				case CPipeline::PIPELINE_GET:
+					m_result.appendResult((*m_client)->getInputProtocol().get(), "get");
+					return HBASE_OK;
+				case CPipeline::PIPELINE_PUT:
+					(*m_client)->recv_put();
+					return HBASE_OK;
+				case CPipeline::PIPELINE_DELETE:
+					(*m_client)->recv_deleteSingle();
+					return HBASE_OK;
+				}
+			}
+			catch (apache::hadoop::hbase::thrift2::TIOError& ex) {
+				LERROR("pipeline {} IOError: {}", table.c_str(), ex.message.c_str());
+				error = HBASE_IO_ERROR;
+			}
+			catch (apache::hadoop::hbase::thrift2::TIllegalArgument& ex) {
+				LERROR("pipeline {} exception: {}", table.c_str(), ex.message.c_str());
+				error = HBASE_ILLEGAL_ARGUMENT;
+			}
+			catch (apache::thrift::TApplicationException& ex) {
+				LERROR("pipeline {} application exception: ({}){}", table.c_str(), ex.getType(), ex.what());
+				error = HBASE_APPLICATION_ERROR;
+			}
+			if (op.type == CPipeline::PIPELINE_GET) m_result.appendEmptyRow();
+			return error;
+		}
+
+		bool CHBaseQuery::openScanner(const std::string &table, CScan &scan)
+		{
+			closeScanner();
+			m_result.clear();
+			m_table = table;
+			m_scanBatch = scan.m_nCacheRows > 0 ? scan.m_nCacheRows : 100;
+			scan.m_scan.__set_caching(m_scanBatch);
+			CCallProbe probe = beginCall(HBASE_OP_OPEN_SCANNER, table);
+			for (int i = 0; i < m_retryTimes; ++i) {
+				try {
+					m_scannerId = (*m_client)->openScanner(table, scan.m_scan);
+					endCall(probe, i, true);	// Ԥȡ̲߳߳ټ¼
+					if (scan.m_nPrefetch > 0) startPrefetch(scan.m_nPrefetch);
+					return true;
+				}
+				CATCH("open scanner from")
+			}
+			return endCall(probe, m_retryTimes - 1, false);
+		}
+
+		void CHBaseQuery::closeScanner()
+		{
+			stopPrefetch();
+			if (m_scannerId < 0) return;
+			const std::string &table = m_table;
+			CCallProbe probe = beginCall(HBASE_OP_CLOSE_SCANNER, table);
+			bool ok = false;
+			try {
+				(*m_client)->closeScanner(m_scannerId);
+				ok = true;
+			}
+			CATCH("close scanner of")
+			endCall(probe, 0, ok);
+			m_scannerId = -1;
+		}
+
+		bool CHBaseQuery::fetchScannerRows()	// ɨǰԣֱӹر
+		{
+			if (m_scannerId < 0) return false;
+			const std::string &table = m_table;
+			m_result.clear();
+			if (m_prefetchQueue) {
+				if (m_prefetchQueue->pop(m_result)) return true;
+				closeScanner();
+				return false;
+			}
+			CCallProbe probe = beginCall(HBASE_OP_SCANNER_ROWS, table);
+			bool ok = false;
+			try {
+				(*m_client)->send_getScannerRows(m_scannerId, m_scanBatch);
+				m_result.recvResults((*m_client)->getInputProtocol().get(), "getScannerRows");
+				ok = true;
+			}
+			CATCH("fetch scanner rows from")
+			endCall(probe, 0, ok);
+			if (ok && !m_result.empty()) return true;
+			closeScanner();
 			return false;
 		}
 
+		bool CHBaseQuery::getRegionLocations(const std::string &table, std::vector<THRegionLocation> &locations)
+		{
+			locations.clear();
+			CCallProbe probe = beginCall(HBASE_OP_REGION_LOCATION, table);
+			for (int i = 0; i < m_retryTimes; ++i) {
+				try {
+					(*m_client)->getAllRegionLocations(locations, table);
+					return endCall(probe, i, true);
+				}
+				CATCH("get region locations of")
+			}
+			return endCall(probe, m_retryTimes - 1, false);
+		}
+
+		bool CHBaseQuery::getRegionLocation(const std::string &table, const std::string &row, THRegionLocation &location, bool reload)
+		{
+			CCallProbe probe = beginCall(HBASE_OP_REGION_LOCATION, table);
+			for (int i = 0; i < m_retryTimes; ++i) {
+				try {
+					(*m_client)->getRegionLocation(location, table, row, reload);
+					return endCall(probe, i, true);
+				}
+				CATCH("get region location of")
+			}
+			return endCall(probe, m_retryTimes - 1, false);
+		}
+
+		void CHBaseQuery::startPrefetch(int batches)	// ÷ѵ N ʱ̨߳ȡ N+1 
+		{
+			m_prefetchQueue.reset(new threadsafe_bounded_queue<CResultBatch>(batches));
+			if (m_pMetrics) tableMetrics(m_table);		// ڱָ߳̽꣬Ԥȡ߳ﲻٸ m_tableMetrics
+			m_prefetchThread = std::thread([this]() {
+				const std::string &table = m_table;
+				for (;;) {
+					CResultBatch batch;
+					CCallProbe probe = beginCall(HBASE_OP_SCANNER_ROWS, table);
+					bool ok = false;
+					try {
+						(*m_client)->send_getScannerRows(m_scannerId, m_scanBatch);
+						batch.recvResults((*m_client)->getInputProtocol().get(), "getScannerRows");
+						ok = true;
+					}
+					CATCH("prefetch scanner rows from")
+					endCall(probe, 0, ok);
+					if (batch.empty() || !m_prefetchQueue->push(std::move(batch))) break;
+				}
+				m_prefetchQueue->close();
+			});
+		}
+
+		void CHBaseQuery::stopPrefetch()
+		{
+			if (!m_prefetchQueue) return;
+			m_prefetchQueue->close();
+			if (m_prefetchThread.joinable()) m_prefetchThread.join();
+			m_prefetchQueue.reset();
+		}
+
+		void CHBaseQuery::reset()
+		{
+			closeScanner();
+			m_result.clear();
+			m_lastError = HBASE_OK;
+		}
+
 		void CHBaseQuery::setRetryTimes(const int &count) // Դ
 		{
 			m_retryTimes = count;
@@ -383,34 +1071,34 @@ namespace hbase {
 			return m_client;
 		}
 
-		std::string CHBaseQuery::getRowkey()
+		CStringView CHBaseQuery::getRowkey() const
 		{
-			return m_RowCurrIter->row;
+			return m_result.getRowkey();
 		}
 
-		std::string CHBaseQuery::getFamilyName() 
+		CStringView CHBaseQuery::getFamilyName() const
 		{
-			return m_CloumnCurrIter->family;
+			return m_result.getFamilyName();
 		}
 
-		std::string CHBaseQuery::getColumnName()
+		CStringView CHBaseQuery::getColumnName() const
 		{
-			return m_CloumnCurrIter->qualifier;
+			return m_result.getColumnName();
 		}
 
-		std::string CHBaseQuery::getColumnValue()
+		CStringView CHBaseQuery::getColumnValue() const
 		{
-			return m_CloumnCurrIter->value;
+			return m_result.getColumnValue();
 		}
 
-		uint64_t CHBaseQuery::getTimestamp()
+		uint64_t CHBaseQuery::getTimestamp() const
 		{
-			return m_CloumnCurrIter->timestamp;
+			return m_result.getTimestamp();
 		}
 
 		//////////////////////////////////////////////////////////////////////////////////////////////////
 
-		CHBaseThrift::CHBaseThrift()
+		CHBaseThrift::CHBaseThrift():m_pLocator(new CRegionLocator(*this)), m_pMetrics(new CHBaseMetrics())
 		{
 
 		}
@@ -422,14 +1110,27 @@ namespace hbase {
 
 		bool CHBaseThrift::open(int size)
 		{
-			m_pConnPool = std::make_unique<CHBaseConnPool>(m_private);
-			m_pConnPool->InitConnpool(size);
+			std::shared_ptr<CHBaseConnPool> pool = std::make_shared<CHBaseConnPool>(m_private, m_pMetrics.get());
+			pool->InitConnpool(size);
+			std::atomic_store(&m_pConnPool, pool);		// ھӳϵȴ̸߳Գһݣᱻͷ
+			if (m_private.shared_connections > 0)
+			{
+				m_pShared.reset(new CHBaseSharedClient(m_private, m_pMetrics.get()));
+				m_pShared->open(m_private.shared_connections);
+			}
+			if (m_private.metrics_port > 0)
+			{
+				m_pMetricsServer.reset(new CMetricsServer(*this));
+				if (!m_pMetricsServer->start(m_private.metrics_port, m_private.metrics_host)) m_pMetricsServer.reset();	// ˶˿ڲӰѯ
+			}
 			return true;
 		}
 
 		bool CHBaseThrift::close()
 		{
+			m_pMetricsServer.reset();		// ֹͣٶȡӳ
 			if (m_pConnPool) m_pConnPool->DestoryConnPool();
+			if (m_pShared) m_pShared->close();
 			return true;
 		}	
 
@@ -445,19 +1146,97 @@ namespace hbase {
 			m_private.send_timeout = s_timeout;
 		}
 
+		void CHBaseThrift::setProtocol(ThriftTransportType transport, ThriftProtocolType protocol)
+		{
+			m_private.transport = transport;
+			m_private.protocol = protocol;
+		}
+
+		void CHBaseThrift::setThreadCache(const int &size, const int &idle_timeout)
+		{
+			m_private.thread_cache_size = size;
+			m_private.thread_cache_idle = idle_timeout;
+		}
+
+		void CHBaseThrift::setAcquireTimeout(const int &timeout)
+		{
+			m_private.acquire_timeout = timeout;
+		}
+
+		void CHBaseThrift::setSharedConnections(const int &count)
+		{
+			m_private.shared_connections = count;
+		}
+
+		void CHBaseThrift::setMetricsEndpoint(const int &port, const std::string &host)
+		{
+			m_private.metrics_port = port;
+			m_private.metrics_host = host;
+		}
+
+		CHBasePoolStats CHBaseThrift::getPoolStats()
+		{
+			return m_pConnPool ? m_pConnPool->getStats() : CHBasePoolStats();
+		}
+
+		void CHBaseThrift::setKeepalive(const int &interval, const std::string &table, const std::string &row)
+		{
+			m_private.keepalive_interval = interval;
+			m_private.ping_table = table;
+			m_private.ping_row = row;
+		}
+
+		void CHBaseThrift::setIdleSize(const int &min_idle, const int &idle_timeout)
+		{
+			m_private.min_idle = min_idle;
+			m_private.idle_timeout = idle_timeout;
+		}
+
 		void CHBaseThrift::releaseQuery(CHBaseQuery * pQuery, bool bRelease)
 		{
+			std::shared_ptr<CHBaseConnPool> pool = std::atomic_load(&m_pConnPool);
+			if (bRelease && m_private.thread_cache_size > 0)	// ȷŻر̻߳棬ٹ黹ӳ
+			{
+				std::lock_guard<std::mutex> lk(t_queryCache.mutex);
+				t_queryCache.bind(pool);
+				pQuery->reset();
+				t_queryCache.queries.push_back(std::make_pair(pQuery, std::chrono::steady_clock::now()));
+				t_queryCache.trim(m_private.thread_cache_size, std::chrono::milliseconds(m_private.thread_cache_idle));
+				return;
+			}
 			std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> conn = pQuery->getConnection();
-			m_pConnPool->ReleaseConnection(conn, bRelease);
-			delete pQuery;
+			delete pQuery;		// ȹرɨٹ黹
+			if (pool) pool->ReleaseConnection(conn, bRelease);
+			else conn->close();
 		}
 
 		CHBaseQuery * CHBaseThrift::getQuery()
+		{
+			return getQuery(m_private.acquire_timeout);
+		}
+
+		CHBaseQuery * CHBaseThrift::getQuery(const int &timeout)
 		{
 			CHBaseQuery * query = nullptr;
-			std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> pConn = m_pConnPool->GetConnection();
+			std::shared_ptr<CHBaseConnPool> pool = std::atomic_load(&m_pConnPool);	// ȴڼӳأopen 滻ӳʱͷ
+			if (!pool) return query;
+			if (m_private.thread_cache_size > 0)
+			{
+				std::lock_guard<std::mutex> lk(t_queryCache.mutex);
+				t_queryCache.bind(pool);
+				t_queryCache.trim(m_private.thread_cache_size, std::chrono::milliseconds(m_private.thread_cache_idle));	// Ȱʱ̭
+				while (!t_queryCache.queries.empty())
+				{
+					query = t_queryCache.queries.back().first;
+					t_queryCache.queries.pop_back();
+					if (query->getConnection()->is_alive()) return query;		// Զ˿жϿ socket ɶ÷
+					t_queryCache.release(query);
+				}
+				query = nullptr;
+			}
+			std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> pConn = pool->GetConnection(timeout);
 			if (pConn){
-				query = new CHBaseQuery(pConn);
+				query = new CHBaseQuery(pConn, m_pMetrics.get());
 			}
 			else LWARN("get query failed!");
 			return query;
@@ -1,10 +1,15 @@
 #pragma once
 #include <string.h>
+#include <deque>
+#include <thread>
+#include <condition_variable>
 #include "hbase/THBaseService.h"
 #include "boost/lockfree/queue.hpp"
 #include "thriftclient.h"
 #include "singleton.h"
 #include "container.h"
+#include "resultbatch.h"
+#include "metrics.h"
 #include "timer.h"
 
 using namespace apache::hadoop::hbase::thrift2;
@@ -15,41 +20,110 @@ namespace hbase {
 		class CGet;
 		class CScan;
 		class CMulitGet;
+		class CMulitPut;
+		class CDelete;
+		class CMulitDelete;
+		class CParallelScan;
+		class CBufferedMutator;
+		class CRegionLocator;
+		class CColumnarBatch;
+		class CPipeline;
+		class CHBaseSharedClient;
+		class CMetricsServer;
 		class CHBaseQuery;
 		class CHBaseThrift;
 		/////////////////////////////////////////// STRUCT && CLASS /////////////////////////////////////////////
+		enum HBaseError		// CHBaseQuery һʧܵԭ
+		{
+			HBASE_OK = 0,
+			HBASE_IO_ERROR,				//  TIOErrorͨ region ûǨ
+			HBASE_TRANSPORT_ERROR,		// 
+			HBASE_APPLICATION_ERROR,
+			HBASE_ILLEGAL_ARGUMENT,
+			HBASE_PROTOCOL_ERROR,
+		};
+
 		struct CHBasePrivate 
 		{
 			int			send_timeout = 2000;
 			int			connect_timeout = 2000;			// ӳʱ
 			int			recive_timeout = 2000;				// ճʱ
 			std::string host_list = "";					// Դ
+			ThriftTransportType transport = THRIFT_TRANSPORT_BUFFERED;	//  thrift2 server  -f һ
+			ThriftProtocolType	protocol = THRIFT_PROTOCOL_BINARY;		//  thrift2 server  -c һ
+			int			thread_cache_size = 0;				// ÿ̻߳Ĳѯ0 ʾ
+			int			thread_cache_idle = 60000;			// ̻߳Ĳѯгú黹ӳ
+			int			acquire_timeout = 0;				// ӳغľʱŶӵȴĺ0 ʾ
+			std::string ping_table = "hbase:meta";			// ̽ exists ıκӦΪӿ
+			std::string ping_row = "ping";
+			int			keepalive_interval = 30000;		// ӳúûշ̽һΣ0 ̽
+			int			min_idle = 0;						// άԤȲֵٿ
+			int			idle_timeout = 300000;				//  min_idle ӿгúرգ0 
+			int			shared_connections = 0;				// ̹߳õĲ0 ʾ
+			int			metrics_port = 0;					// /metrics ˿ڣ0 ʾ
+			std::string metrics_host = "0.0.0.0";
+		};
+
+		struct CHBasePoolStats		// ӳͳ
+		{
+			int			cur_size = 0;						// Ѵ
+			int			idle_size = 0;						// ()
+			int			waiters = 0;						// Ŷӵ߳
+			uint64_t	acquires = 0;						// ȡɹ
+			uint64_t	waits = 0;							// ҪŶӵĴ
+			uint64_t	timeouts = 0;						// Ŷӳʱ
+			uint64_t	wait_us_total = 0;					// Ŷܺʱ(΢)
+			uint64_t	wait_us_max = 0;					// Ŷʱ(΢)
 		};
 
 		class CHBaseConnPool	// ӳ
 		{
 		public:
-			explicit CHBaseConnPool(const CHBasePrivate &pri);
-			~CHBaseConnPool() {}
+			explicit CHBaseConnPool(const CHBasePrivate &pri, CHBaseMetrics *metrics = NULL);
+			~CHBaseConnPool() { DestoryConnPool(); }		// 滻ʱҲҪͣά
 
 			bool  InitConnpool(int maxSize);
-			std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> GetConnection();
+			std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> GetConnection(int timeout = 0);	// غľʱŶ timeout 
 			void  DestoryConnPool();			// ӳ	
 			void  ReleaseConnection(std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> conn, bool bRelease = true);
 			void  onTimer();
+			CHBasePoolStats getStats();
+			static void parseHostList(const std::string &lists, std::vector<std::pair<std::string, int>> &servers);	// "ip:port,ip:port"
 		protected:
 			std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> getFreeConn();
+			std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> tryConnection();				// ȡӻ½ȴ
+			std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> waitConnection(int timeout);
 			std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> createConnection();			// һ
 			void  putFreeConn(std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> conn);
+			bool  ping(const std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> &conn);
+			bool  reserveSlot();				// ռһɹɵ÷
+			void  freeSlot();					// ͷǰĵȴ³
 
 		private:
+			struct CWaiter
+			{
+				std::condition_variable											cond;
+				std::shared_ptr<CThriftClientHelper<THBaseServiceClient>>		conn;		// 黹ֱӽȴߵ
+				bool															retry = false;	// ͷţӺԼȥ½
+			};
 
 			int																  m_maxSize;		// ӳص
 			std::atomic<int>												  m_curSize;		// ǰӳԾ
 			CHBasePrivate													  m_private;		// ˽
 			std::vector<std::pair<std::string, int>>						  m_servers;
-			threadsafe_list<CThriftClientHelper<THBaseServiceClient>>		  m_connList;
+			std::unique_ptr<lockfree_bounded_queue<std::shared_ptr<CThriftClientHelper<THBaseServiceClient>>>> m_freeConns;	// ӣΪ m_maxSize
 			CTimer<boost::posix_time::milliseconds>							  m_timer;
+			std::mutex														  m_waitMutex;
+			std::deque<CWaiter *>											  m_waiters;		// Ƚȳ
+			std::atomic<int>												  m_waiterCount;	// ޵ȴʱ黹
+			std::atomic<bool>												  m_shutdown;		// DestoryConnPool ֮άУ黹ֱӹر
+			std::mutex														  m_maintainMutex;	// onTimer ڼ
+			std::atomic<uint64_t>											  m_acquires;
+			std::atomic<uint64_t>											  m_waits;
+			std::atomic<uint64_t>											  m_timeouts;
+			std::atomic<uint64_t>											  m_waitUsTotal;
+			std::atomic<uint64_t>											  m_waitUsMax;
+			CHBaseMetrics													  *m_pMetrics;		// Ϊ NULL
 		};
 
 		class CPut
@@ -60,12 +134,54 @@ namespace hbase {
 			void setRowkey(const std::string& rowkey);
 			void appendColumn(const std::string &family, const std::string &qualifier, const std::string &value);
 			void setDurability(TDurability::type durability = TDurability::SYNC_WAL);
+			friend CMulitPut;
 			friend CHBaseQuery;
+			friend CHBaseSharedClient;
+			friend CBufferedMutator;
+			friend CPipeline;
 		private:
 			apache::hadoop::hbase::thrift2::TPut					  m_put;
 			std::vector<apache::hadoop::hbase::thrift2::TColumnValue> m_familys;
 		};
 
+		class CDelete
+		{
+		public:
+			CDelete();
+			~CDelete();
+			void setRowkey(const std::string& rowkey);
+			void appendColumn(const std::string &family, const std::string &qualifier);	// ָʱɾ
+			void setDurability(TDurability::type durability = TDurability::SYNC_WAL);
+			friend CMulitDelete;
+			friend CHBaseQuery;
+			friend CHBaseSharedClient;
+			friend CBufferedMutator;
+			friend CPipeline;
+		private:
+			apache::hadoop::hbase::thrift2::TDelete					m_delete;
+			std::vector<apache::hadoop::hbase::thrift2::TColumn>	m_familys;
+		};
+
+		class CMulitDelete
+		{
+		public:
+			CMulitDelete() {}
+			~CMulitDelete() {}
+			void clear() { m_deletes.clear(); }
+			size_t size() const { return m_deletes.size(); }
+			bool empty() const { return m_deletes.empty(); }
+			void swap(CMulitDelete &other) { m_deletes.swap(other.m_deletes); }
+			void appendDelete(CDelete &del) {
+				if (!del.m_familys.empty()) del.m_delete.__set_columns(del.m_familys);
+				m_deletes.push_back(del.m_delete);
+			}
+			friend CHBaseQuery;
+			friend CHBaseSharedClient;
+			friend CBufferedMutator;
+		private:
+			std::vector<apache::hadoop::hbase::thrift2::TDelete>   m_deletes;
+		};
+
 		class CGet
 		{
 		public:
@@ -78,9 +194,10 @@ namespace hbase {
 			void setTimeRange(const int64_t &begin, const int64_t &end);
 			friend CMulitGet;
 			friend CHBaseQuery;
+			friend CHBaseSharedClient;
+			friend CPipeline;
 		private:
 			apache::hadoop::hbase::thrift2::TGet					m_get;
-			std::vector<apache::hadoop::hbase::thrift2::TColumn>	m_familys;
 		};
 
 		class CMulitGet
@@ -89,15 +206,35 @@ namespace hbase {
 			CMulitGet() {}
 			~CMulitGet() {}
 			void clear() { m_gets.clear(); }
-			void appendGet(CGet &get) { 
-				get.m_get.__set_columns(get.m_familys);
-				m_gets.push_back(get.m_get);
-			}
+			void reserve(size_t count) { m_gets.reserve(count); }
+			void appendGet(const CGet &get) { m_gets.push_back(get.m_get); }
+			void appendGet(CGet &&get) { m_gets.push_back(std::move(get.m_get)); }	// ʹ get ʱ룬ʡȥһ
 			friend CHBaseQuery;
+			friend CHBaseSharedClient;
 		private:
 			std::vector<apache::hadoop::hbase::thrift2::TGet>   m_gets;
 		};
 
+		class CMulitPut
+		{
+		public:
+			CMulitPut() {}
+			~CMulitPut() {}
+			void clear() { m_puts.clear(); }
+			size_t size() const { return m_puts.size(); }
+			bool empty() const { return m_puts.empty(); }
+			void swap(CMulitPut &other) { m_puts.swap(other.m_puts); }
+			void appendPut(CPut &put) {
+				put.m_put.__set_columnValues(put.m_familys);
+				m_puts.push_back(put.m_put);
+			}
+			friend CHBaseQuery;
+			friend CHBaseSharedClient;
+			friend CBufferedMutator;
+		private:
+			std::vector<apache::hadoop::hbase::thrift2::TPut>   m_puts;
+		};
+
 		class CScan
 		{
 		public:	
@@ -106,46 +243,123 @@ namespace hbase {
 			void setCaching(const int &count);				// Ҫѯ
 			void setBatchSize(const int &size);				// Ҫѯ
 			void setReversed(const bool &rev = false);
+			void setPrefetch(const int &batches = 1);			// openScanner Ԥȡ0 Ԥȡ
 			void setMaxVersion(const uint16_t &version = 0);
 			void setFilterString(const char* format, ...);
 			void setTimeRange(const int64_t &begin, const int64_t &end);	
 			void setRowRange(const std::string& begin_row, const std::string& stop_row);
 			void appendColumn(const std::string &family, const std::string &qualifier);
 			friend CHBaseQuery;
+			friend CHBaseSharedClient;
+			friend CParallelScan;
 		private:
 			int														m_nCacheRows;
+			int														m_nPrefetch;
 			apache::hadoop::hbase::thrift2::TScan					m_scan;
-			std::vector<apache::hadoop::hbase::thrift2::TColumn>	m_familys;
+		};
+
+		// һ黥 get/put/deleteCHBaseQuery::execPipeline ͬһٰ˳ӦֻԼһ RTT
+		// ÿ get ڽռһ(ʧܻ򲻴ʱΪ)Ľ getError 鿴
+		class CPipeline
+		{
+		public:
+			CPipeline() {}
+			~CPipeline() {}
+			void clear();
+			size_t size() const { return m_ops.size(); }
+			bool empty() const { return m_ops.empty(); }
+			void appendGet(const std::string &table, const CGet &get);
+			void appendPut(const std::string &table, CPut &put);
+			void appendDelete(const std::string &table, CDelete &del);
+			HBaseError getError(size_t index) const { return m_errors[index]; }	// execPipeline ֮󣬰 append ˳
+			friend CHBaseQuery;
+		private:
+			enum OpType
+			{
+				PIPELINE_GET,
+				PIPELINE_PUT,
+				PIPELINE_DELETE,
+			};
+			struct COp
+			{
+				OpType		type;
+				uint32_t	table;		// m_tables ±
+				uint32_t	index;		// Ӧ m_gets/m_puts/m_deletes ±
+			};
+			uint32_t tableIndex(const std::string &table);
+
+			std::vector<COp>										m_ops;
+			std::vector<std::string>								m_tables;
+			std::vector<apache::hadoop::hbase::thrift2::TGet>		m_gets;
+			std::vector<apache::hadoop::hbase::thrift2::TPut>		m_puts;
+			std::vector<apache::hadoop::hbase::thrift2::TDelete>	m_deletes;
+			std::vector<HBaseError>									m_errors;
 		};
 
 		// ̲߳ȫֹ̹߳һquery
 		class CHBaseQuery
 		{
 		public:
-			CHBaseQuery(std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> client);
+			CHBaseQuery(std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> client, CHBaseMetrics *metrics = NULL);	// metrics Ϊ NULL ʱͳ
 			~CHBaseQuery();
 
 			bool nextColumn();
 			bool nextRow();
+			CRowRange<CHBaseQuery> rows() { return CRowRange<CHBaseQuery>(*this); }	// for (const CRowRef &row : query.rows()) for (const CCell &cell : row)
+			bool fetchColumnar(CColumnarBatch &columns);							// ѵǰʣתʽʽɨԶȡһ
+			void swapResult(CResultBatch &batch) { std::swap(m_result, batch); }	// ȡ첽ӿ
+			bool fetchBatch(CResultBatch &batch);									// ʽɨȡһɨ false getLastError 
+			void reset();															// սرɨ
 			bool execGet(const std::string &table, CGet &get);
 			bool execPut(const std::string &table, CPut &put);
 			bool execMulitGet(const std::string &table, CMulitGet &mulit_get);
+			bool execMulitPut(const std::string &table, CMulitPut &mulit_put);
+			bool execMulitDelete(const std::string &table, CMulitDelete &mulit_delete, CMulitDelete *failed = NULL);	// Ķ mulit_deletefailed δɾ
 			bool execScan(const std::string &table, CScan &scan);
+			bool execPipeline(CPipeline &pipeline, size_t window = 64);				//  window ;ȫɹ true get ˳жȡ
+			bool openScanner(const std::string &table, CScan &scan);				// ʽɨ裬nextRow һԶȡһ
+			void closeScanner();
+			bool getRegionLocations(const std::string &table, std::vector<THRegionLocation> &locations);
+			bool getRegionLocation(const std::string &table, const std::string &row, THRegionLocation &location, bool reload = false);
+			HBaseError getLastError() const { return static_cast<HBaseError>(m_lastError.load()); }
 			void setRetryTimes(const int &count);									// Դ
-			std::string getRowkey();
-			std::string getFamilyName();
-			std::string getColumnName();
-			std::string getColumnValue();
-			uint64_t getTimestamp();
+			CRowRef getRow() const { return m_result.getRow(); }
+			const CCell &getCell() const { return m_result.getCell(); }
+			CStringView getRowkey() const;										// صͼһ exec*/nextRow ֮ǰЧ
+			CStringView getFamilyName() const;
+			CStringView getColumnName() const;
+			CStringView getColumnValue() const;
+			uint64_t getTimestamp() const;
 			std::shared_ptr<CThriftClientHelper<THBaseServiceClient>> getConnection();
 		private:
+			struct CCallProbe	// һ exec ʼʱʱֽ
+			{
+				COpMetrics								*metrics;
+				std::chrono::steady_clock::time_point	begin;
+				uint64_t								sent;
+				uint64_t								received;
+			};
+			COpMetrics *tableMetrics(const std::string &table);
+			CCallProbe beginCall(HBaseOp op, const std::string &table);
+			bool endCall(const CCallProbe &probe, int retry_count, bool ok);
+			bool fetchScannerRows();
+			void sendPipelineOp(const CPipeline &pipeline, size_t index);
+			HBaseError recvPipelineOp(const CPipeline &pipeline, size_t index);
+			void startPrefetch(int batches);
+			void stopPrefetch();
+
 			int																		  m_retryTimes;
+			std::atomic<int>														  m_lastError;		// Ԥȡ߳Ҳд
+			int32_t																	  m_scannerId;		// ǰ򿪵ɨ-1 ʾû
+			int32_t																	  m_scanBatch;		// ÿ getScannerRows ȡ
+			std::string																  m_table;
+			std::thread																  m_prefetchThread;	// Ԥȡ̣߳ڼռ m_client
+			std::unique_ptr<threadsafe_bounded_queue<CResultBatch>>					  m_prefetchQueue;
 			std::shared_ptr<CThriftClientHelper<THBaseServiceClient>>				  m_client;
-			std::vector<apache::hadoop::hbase::thrift2::TResult>					  m_result;
-			std::vector<apache::hadoop::hbase::thrift2::TResult>::const_iterator	  m_RowIter;			// row iter
-			std::vector<apache::hadoop::hbase::thrift2::TResult>::const_iterator	  m_RowCurrIter;		// row curr iter
-			std::vector<apache::hadoop::hbase::thrift2::TColumnValue>::const_iterator m_CloumnIter;			// cloumn iter
-			std::vector<apache::hadoop::hbase::thrift2::TColumnValue>::const_iterator m_CloumnCurrIter;		// cloumn curr iter
+			CResultBatch															  m_result;			// ǰμα꣬ÿ exec λ arena ڴ
+			CHBaseMetrics															  *m_pMetrics;
+			std::string																  m_metricsTable;	// m_tableMetrics Ӧıͬһűٲ
+			COpMetrics																  *m_tableMetrics;
 		};
 
 		class CHBaseThrift
@@ -155,11 +369,27 @@ namespace hbase {
 			bool open(int size = 1);
 			void setHostlist(const std::string &lists);
 			void setTimeout(const int &c_timeout = 2000, const int &r_timeout = 2000, const int &s_timeout = 2000);
+			void setProtocol(ThriftTransportType transport = THRIFT_TRANSPORT_FRAMED, ThriftProtocolType protocol = THRIFT_PROTOCOL_COMPACT);	// open ǰ
+			void setThreadCache(const int &size = 2, const int &idle_timeout = 60000);		// open ǰã߳ڸòѯӣӳ
+			void setAcquireTimeout(const int &timeout = 1000);								// ӳغľʱ getQuery Ŷӵȴĺ
+			void setKeepalive(const int &interval = 30000, const std::string &table = "hbase:meta", const std::string &row = "ping");
+			void setIdleSize(const int &min_idle = 0, const int &idle_timeout = 300000);	// open ǰą̃ά
+			void setSharedConnections(const int &count = 4);								// open ǰã̹߳õĲ
+			void setMetricsEndpoint(const int &port, const std::string &host = "0.0.0.0");	// open ǰãopen ʱʼ Prometheus ʽṩ /metrics
+			CHBasePoolStats getPoolStats();
+			CHBaseMetricsSnapshot getMetrics() { return m_pMetrics->snapshot(); }			// 󰴱ӳٷֲֽԺۼֵ
 			void releaseQuery(CHBaseQuery * pQuery, bool bRelease = true);
 			CHBaseQuery * getQuery();
+			CHBaseQuery * getQuery(const int &timeout);		// ӳغľʱŶ timeout 룬 setAcquireTimeout Ӱ
+			CRegionLocator & getRegionLocator() { return *m_pLocator; }		// вѯ region λû
+			CHBaseSharedClient * getSharedClient() { return m_pShared.get(); }	// δ setSharedConnections ʱΪ NULL
 		private:
 			CHBasePrivate						m_private;
-			std::unique_ptr<CHBaseConnPool>		m_pConnPool;
+			std::shared_ptr<CHBaseConnPool>		m_pConnPool;		// ̻߳ weak_ptrclose ٹ黹
+			std::unique_ptr<CRegionLocator>		m_pLocator;
+			std::unique_ptr<CHBaseSharedClient>	m_pShared;
+			std::unique_ptr<CHBaseMetrics>		m_pMetrics;		//  close 
+			std::unique_ptr<CMetricsServer>		m_pMetricsServer;
 		};
 	}
 } // namespace end of hbase
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include "metrics.h"
+#include <algorithm>
+#include <map>
+#include "boost/thread/locks.hpp"
+
+namespace hbase {
+	namespace thrift2 {
+
+		const char *hbaseOpName(HBaseOp op)
+		{
+			static const char *names[HBASE_OP_COUNT] = { "get", "mulit_get", "put", "mulit_put", "mulit_delete", "scan",
+				"open_scanner", "scanner_rows", "close_scanner", "pipeline", "region_location" };
+			return op >= 0 && op < HBASE_OP_COUNT ? names[op] : "unknown";
+		}
+
+		//////////////////////////////////////////////// CLatencySnapshot ///////////////////////////////////////////////////
+		uint64_t CLatencySnapshot::percentile(double q) const
+		{
+			if (count == 0 || buckets.empty()) return 0;
+			uint64_t rank = static_cast<uint64_t>(q * count);
+			if (rank >= count) rank = count - 1;
+			uint64_t seen = 0;
+			for (size_t i = 0; i < buckets.size(); ++i)
+			{
+				seen += buckets[i];
+				if (seen > rank) return std::min(CLatencyHistogram::bucketUpper(i), max_us);
+			}
+			return max_us;
+		}
+
+		void CLatencySnapshot::merge(const CLatencySnapshot &other)
+		{
+			if (other.count == 0) return;
+			if (buckets.size() < other.buckets.size()) buckets.resize(other.buckets.size(), 0);
+			for (size_t i = 0; i < other.buckets.size(); ++i) buckets[i] += other.buckets[i];
+			count += other.count;
+			sum_us += other.sum_us;
+			max_us = std::max(max_us, other.max_us);
+		}
+
+		//////////////////////////////////////////////// CLatencyHistogram ///////////////////////////////////////////////////
+		CLatencyHistogram::CLatencyHistogram() :m_count(0), m_sum(0), m_max(0)
+		{
+			for (auto &bucket : m_buckets) bucket.store(0, std::memory_order_relaxed);
+		}
+
+		size_t CLatencyHistogram::bucketIndex(uint64_t us)
+		{
+			if (us < SUB_COUNT) return static_cast<size_t>(us);
+			int exponent = 63 - __builtin_clzll(us);		// λ>= SUB_BITS
+			if (exponent >= MAX_BITS) return BUCKETS - 1;
+			int shift = exponent - SUB_BITS;
+			return static_cast<size_t>((shift + 1) * SUB_COUNT + ((us >> shift) - SUB_COUNT));
+		}
+
+		uint64_t CLatencyHistogram::bucketUpper(size_t index)
+		{
+			if (index < SUB_COUNT) return index;
+			int shift = static_cast<int>(index / SUB_COUNT) - 1;
+			uint64_t sub = index % SUB_COUNT + SUB_COUNT;
+			return ((sub + 1) << shift) - 1;
+		}
+
+		void CLatencyHistogram::record(uint64_t us)
+		{
+			m_buckets[bucketIndex(us)].fetch_add(1, std::memory_order_relaxed);
+			m_count.fetch_add(1, std::memory_order_relaxed);
+			m_sum.fetch_add(us, std::memory_order_relaxed);
+			uint64_t max = m_max.load(std::memory_order_relaxed);
+			while (us > max && !m_max.compare_exchange_weak(max, us, std::memory_order_relaxed));
+		}
+
+		CLatencySnapshot CLatencyHistogram::snapshot() const
+		{
+			CLatencySnapshot snapshot;
+			snapshot.count = m_count.load(std::memory_order_relaxed);
+			if (snapshot.count == 0) return snapshot;
+			snapshot.sum_us = m_sum.load(std::memory_order_relaxed);
+			snapshot.max_us = m_max.load(std::memory_order_relaxed);
+			size_t used = 0;		// ֻһǿͰ
+			snapshot.buckets.resize(BUCKETS);
+			for (size_t i = 0; i < BUCKETS; ++i)
+			{
+				snapshot.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+				if (snapshot.buckets[i]) used = i + 1;
+			}
+			snapshot.buckets.resize(used);
+			return snapshot;
+		}
+
+		//////////////////////////////////////////////// CHBaseMetrics ///////////////////////////////////////////////////
+		COpMetrics *CHBaseMetrics::getTable(const std::string &table)
+		{
+			{
+				boost::shared_lock<boost::shared_mutex> lock(m_mutex);
+				auto iter = m_tables.find(table);
+				if (iter != m_tables.end()) return iter->second->ops;
+			}
+			boost::unique_lock<boost::shared_mutex> lock(m_mutex);
+			std::unique_ptr<CTableMetrics> &metrics = m_tables[table];
+			if (!metrics) metrics.reset(new CTableMetrics());
+			return metrics->ops;
+		}
+
+		CHBaseMetricsSnapshot CHBaseMetrics::snapshot()
+		{
+			CHBaseMetricsSnapshot snapshot;
+			std::map<int, COpSnapshot> totals;
+			{
+				boost::shared_lock<boost::shared_mutex> lock(m_mutex);
+				for (auto &table : m_tables)
+				{
+					for (int op = 0; op < HBASE_OP_COUNT; ++op)
+					{
+						const COpMetrics &metrics = table.second->ops[op];
+						COpSnapshot item;
+						item.calls = metrics.calls.load(std::memory_order_relaxed);
+						if (item.calls == 0) continue;
+						item.op = static_cast<HBaseOp>(op);
+						item.table = table.first;
+						item.errors = metrics.errors.load(std::memory_order_relaxed);
+						item.retries = metrics.retries.load(std::memory_order_relaxed);
+						item.bytes_sent = metrics.bytes_sent.load(std::memory_order_relaxed);
+						item.bytes_received = metrics.bytes_received.load(std::memory_order_relaxed);
+						item.latency = metrics.latency.snapshot();
+
+						COpSnapshot &total = totals[op];
+						total.op = item.op;
+						total.calls += item.calls;
+						total.errors += item.errors;
+						total.retries += item.retries;
+						total.bytes_sent += item.bytes_sent;
+						total.bytes_received += item.bytes_received;
+						total.latency.merge(item.latency);
+						snapshot.tables.push_back(std::move(item));
+					}
+				}
+			}
+			for (auto &total : totals) snapshot.ops.push_back(std::move(total.second));
+			snapshot.inflight = m_inflight.load(std::memory_order_relaxed);
+			snapshot.reconnects = m_reconnects.load(std::memory_order_relaxed);
+			snapshot.pool_wait = m_poolWait.snapshot();
+			return snapshot;
+		}
+	}
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+#include "boost/thread/shared_mutex.hpp"
+
+namespace hbase {
+	namespace thrift2 {
+
+		enum HBaseOp		// ͳƵ
+		{
+			HBASE_OP_GET = 0,
+			HBASE_OP_MULIT_GET,
+			HBASE_OP_PUT,
+			HBASE_OP_MULIT_PUT,
+			HBASE_OP_MULIT_DELETE,
+			HBASE_OP_SCAN,					// getScannerResultsһȡ
+			HBASE_OP_OPEN_SCANNER,
+			HBASE_OP_SCANNER_ROWS,			// ʽɨÿһԤȡ߳
+			HBASE_OP_CLOSE_SCANNER,
+			HBASE_OP_PIPELINE,				// 
+			HBASE_OP_REGION_LOCATION,
+			HBASE_OP_COUNT,
+		};
+		const char *hbaseOpName(HBaseOp op);
+
+		struct CLatencySnapshot
+		{
+			uint64_t				count = 0;
+			uint64_t				sum_us = 0;
+			uint64_t				max_us = 0;
+			std::vector<uint64_t>	buckets;			// ±꺬 CLatencyHistogramΪձʾû
+
+			uint64_t percentile(double q) const;		// ͰϽ( max_us) 1/16
+			void merge(const CLatencySnapshot &other);
+		};
+
+		// ԷͰӳֱͼ(HDR )λ΢룺[0, 16) ÿ΢һͰ֮ÿ 2 ȷ 16 Ͱ
+		// record ֻм relaxed ԭӲsnapshot  record ʱͰ֮䲻֤ͬһʱ
+		class CLatencyHistogram
+		{
+		public:
+			static const int SUB_BITS = 4;
+			static const int SUB_COUNT = 1 << SUB_BITS;
+			static const int MAX_BITS = 40;										//  2^40 ΢ֵһͰ
+			static const int BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_COUNT;
+
+			CLatencyHistogram();
+			void record(uint64_t us);
+			CLatencySnapshot snapshot() const;
+			static size_t bucketIndex(uint64_t us);
+			static uint64_t bucketUpper(size_t index);						// Ͱֵ
+		private:
+			std::atomic<uint64_t>		m_buckets[BUCKETS];
+			std::atomic<uint64_t>		m_count;
+			std::atomic<uint64_t>		m_sum;
+			std::atomic<uint64_t>		m_max;
+		};
+
+		struct COpMetrics		// ĳűĳۼֵ
+		{
+			CLatencyHistogram			latency;			// Եܺʱ
+			std::atomic<uint64_t>		calls{ 0 };
+			std::atomic<uint64_t>		errors{ 0 };		// ԺʧܵĴ
+			std::atomic<uint64_t>		retries{ 0 };
+			std::atomic<uint64_t>		bytes_sent{ 0 };	// socket ϵֽ frame ͷӲͳ
+			std::atomic<uint64_t>		bytes_received{ 0 };
+
+			void record(uint64_t us, int retry_count, bool ok, uint64_t sent, uint64_t received)
+			{
+				latency.record(us);
+				calls.fetch_add(1, std::memory_order_relaxed);
+				if (!ok) errors.fetch_add(1, std::memory_order_relaxed);
+				if (retry_count > 0) retries.fetch_add(retry_count, std::memory_order_relaxed);
+				if (sent) bytes_sent.fetch_add(sent, std::memory_order_relaxed);
+				if (received) bytes_received.fetch_add(received, std::memory_order_relaxed);
+			}
+		};
+
+		struct COpSnapshot
+		{
+			HBaseOp				op = HBASE_OP_GET;
+			std::string			table;						// ͻʱΪ
+			uint64_t			calls = 0;
+			uint64_t			errors = 0;
+			uint64_t			retries = 0;
+			uint64_t			bytes_sent = 0;
+			uint64_t			bytes_received = 0;
+			CLatencySnapshot	latency;
+		};
+
+		struct CHBaseMetricsSnapshot
+		{
+			std::vector<COpSnapshot>	tables;			// ÿűÿһûеùĲг
+			std::vector<COpSnapshot>	ops;			// ͻȫûеùĲг
+			int64_t						inflight = 0;	// ִе
+			uint64_t					reconnects = 0;	// ѯӳرӱĴ
+			CLatencySnapshot			pool_wait;		// getQuery ӳȡӵĵȴʱ䣬ȴļΪ 0
+		};
+
+		// ͻָ꣬ȫۼֵ CHBaseThrift УCHBaseQuery/ӳ/ӸԼ¼
+		// ָ괴ɾַȶCHBaseQuery һűָ룬·ϲҲ
+		class CHBaseMetrics
+		{
+		public:
+			CHBaseMetrics() :m_inflight(0), m_reconnects(0) {}
+
+			COpMetrics *getTable(const std::string &table);		// ñָ꣬ HBaseOp ±ȡָһֱЧ
+			void beginRequest() { m_inflight.fetch_add(1, std::memory_order_relaxed); }
+			void endRequest() { m_inflight.fetch_sub(1, std::memory_order_relaxed); }
+			void addReconnect() { m_reconnects.fetch_add(1, std::memory_order_relaxed); }
+			void recordPoolWait(uint64_t us) { m_poolWait.record(us); }
+			CHBaseMetricsSnapshot snapshot();
+		private:
+			struct CTableMetrics
+			{
+				COpMetrics		ops[HBASE_OP_COUNT];
+			};
+
+			boost::shared_mutex												m_mutex;
+			std::unordered_map<std::string, std::unique_ptr<CTableMetrics>>	m_tables;
+			std::atomic<int64_t>											m_inflight;
+			std::atomic<uint64_t>											m_reconnects;
+			CLatencyHistogram												m_poolWait;
+		};
+	}
+}
@@ -0,0 +1,188 @@
+#include "metricsserver.h"
+#include <stdio.h>
+#include <thrift/transport/TTransportException.h>
+#include "log.h"
+
+namespace hbase {
+	namespace thrift2 {
+
+		static const double QUANTILES[] = { 0.5, 0.9, 0.99, 0.999 };
+
+		static std::string escapeLabel(const std::string &value)	// Prometheus ǩֵת \ " ͻ
+		{
+			std::string escaped;
+			escaped.reserve(value.size());
+			for (char c : value)
+			{
+				if (c == '\\') escaped += "\\\\";
+				else if (c == '"') escaped += "\\\"";
+				else if (c == '\n') escaped += "\\n";
+				else escaped += c;
+			}
+			return escaped;
+		}
+
+		static void appendHeader(std::string &out, const char *name, const char *type, const char *help)
+		{
+			out += "# HELP "; out += name; out += ' '; out += help; out += '\n';
+			out += "# TYPE "; out += name; out += ' '; out += type; out += '\n';
+		}
+
+		static void appendValue(std::string &out, const char *name, const std::string &labels, double value)
+		{
+			char buf[64];
+			snprintf(buf, sizeof(buf), " %.9g\n", value);
+			out += name;
+			if (!labels.empty()) { out += '{'; out += labels; out += '}'; }
+			out += buf;
+		}
+
+		static void appendSummary(std::string &out, const char *name, const std::string &labels, const CLatencySnapshot &latency)	// ΢תΪ
+		{
+			std::string prefix = labels.empty() ? std::string() : labels + ",";
+			char quantile[32];
+			for (double q : QUANTILES)
+			{
+				snprintf(quantile, sizeof(quantile), "quantile=\"%g\"", q);
+				appendValue(out, name, prefix + quantile, latency.percentile(q) / 1e6);
+			}
+			appendValue(out, (std::string(name) + "_sum").c_str(), labels, latency.sum_us / 1e6);
+			appendValue(out, (std::string(name) + "_count").c_str(), labels, static_cast<double>(latency.count));
+		}
+
+		static std::string opLabels(const COpSnapshot &op)
+		{
+			std::string labels = "op=\"";
+			labels += hbaseOpName(op.op);
+			labels += '"';
+			if (!op.table.empty()) labels += ",table=\"" + escapeLabel(op.table) + "\"";
+			return labels;
+		}
+
+		CMetricsServer::CMetricsServer(CHBaseThrift &thrift) :m_thrift(thrift), m_running(false)
+		{
+		}
+
+		CMetricsServer::~CMetricsServer()
+		{
+			stop();
+		}
+
+		bool CMetricsServer::start(int port, const std::string &host)
+		{
+			stop();
+			try
+			{
+				m_socket = std::make_shared<apache::thrift::transport::TServerSocket>(host, port);
+				m_socket->setRecvTimeout(2000);		// ɼ˷ͷʱῨס̨߳
+				m_socket->setSendTimeout(2000);
+				m_socket->listen();
+			}
+			catch (apache::thrift::transport::TTransportException& ex)
+			{
+				LERROR("listen metrics endpoint {}:{} failed: ({}){}", host.c_str(), port, ex.getType(), ex.what());
+				m_socket.reset();
+				return false;
+			}
+			m_running = true;
+			m_thread = std::thread(&CMetricsServer::serve, this);
+			LDEBUG("metrics endpoint listening on {}:{}", host.c_str(), port);
+			return true;
+		}
+
+		void CMetricsServer::stop()
+		{
+			if (!m_running) return;
+			m_running = false;
+			m_socket->interrupt();		//  accept ϵ߳
+			if (m_thread.joinable()) m_thread.join();
+			m_socket->close();
+			m_socket.reset();
+		}
+
+		void CMetricsServer::serve()
+		{
+			while (m_running)
+			{
+				try
+				{
+					handle(m_socket->accept());
+				}
+				catch (apache::thrift::transport::TTransportException& ex)
+				{
+					if (ex.getType() == apache::thrift::transport::TTransportException::INTERRUPTED) break;
+					if (m_running) LERROR("metrics endpoint exception: ({}){}", ex.getType(), ex.what());
+				}
+			}
+		}
+
+		void CMetricsServer::handle(std::shared_ptr<apache::thrift::transport::TTransport> client)
+		{
+			std::string request;
+			uint8_t buf[1024];
+			while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192)	// ֻҪУ
+			{
+				uint32_t got = client->read(buf, sizeof(buf));
+				if (got == 0) break;
+				request.append(reinterpret_cast<char *>(buf), got);
+			}
+
+			std::string status = "200 OK";
+			std::string body;
+			if (request.compare(0, 13, "GET /metrics ") == 0 || request.compare(0, 13, "GET /metrics?") == 0)
+			{
+				body = format(m_thrift.getMetrics(), m_thrift.getPoolStats());
+			}
+			else
+			{
+				status = "404 Not Found";
+				body = "try GET /metrics\n";
+			}
+			std::string response = "HTTP/1.0 " + status + "\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: "
+				+ std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+			client->write(reinterpret_cast<const uint8_t *>(response.data()), static_cast<uint32_t>(response.size()));
+			client->flush();
+			client->close();
+		}
+
+		std::string CMetricsServer::format(const CHBaseMetricsSnapshot &metrics, const CHBasePoolStats &pool)
+		{
+			std::string out;
+			out.reserve(4096 + metrics.tables.size() * 1024);
+
+			appendHeader(out, "hbase_client_pool_connections", "gauge", "Connections created by the pool.");
+			appendValue(out, "hbase_client_pool_connections", "", pool.cur_size);
+			appendHeader(out, "hbase_client_pool_idle_connections", "gauge", "Idle connections in the pool (approximate).");
+			appendValue(out, "hbase_client_pool_idle_connections", "", pool.idle_size);
+			appendHeader(out, "hbase_client_pool_waiters", "gauge", "Threads waiting for a pooled connection.");
+			appendValue(out, "hbase_client_pool_waiters", "", pool.waiters);
+			appendHeader(out, "hbase_client_pool_acquires_total", "counter", "Connections handed out by the pool.");
+			appendValue(out, "hbase_client_pool_acquires_total", "", static_cast<double>(pool.acquires));
+			appendHeader(out, "hbase_client_pool_timeouts_total", "counter", "Pool acquisitions that timed out.");
+			appendValue(out, "hbase_client_pool_timeouts_total", "", static_cast<double>(pool.timeouts));
+			appendHeader(out, "hbase_client_pool_wait_seconds", "summary", "Time spent acquiring a pooled connection.");
+			appendSummary(out, "hbase_client_pool_wait_seconds", "", metrics.pool_wait);
+
+			appendHeader(out, "hbase_client_inflight_requests", "gauge", "Requests currently executing.");
+			appendValue(out, "hbase_client_inflight_requests", "", static_cast<double>(metrics.inflight));
+			appendHeader(out, "hbase_client_reconnects_total", "counter", "Connections re-established after errors or failed keepalive.");
+			appendValue(out, "hbase_client_reconnects_total", "", static_cast<double>(metrics.reconnects));
+
+			appendHeader(out, "hbase_client_requests_total", "counter", "Requests by operation and table.");
+			for (const COpSnapshot &op : metrics.tables) appendValue(out, "hbase_client_requests_total", opLabels(op), static_cast<double>(op.calls));
+			appendHeader(out, "hbase_client_request_errors_total", "counter", "Requests that failed after all retries.");
+			for (const COpSnapshot &op : metrics.tables) appendValue(out, "hbase_client_request_errors_total", opLabels(op), static_cast<double>(op.errors));
+			appendHeader(out, "hbase_client_request_retries_total", "counter", "Retries by operation and table.");
+			for (const COpSnapshot &op : metrics.tables) appendValue(out, "hbase_client_request_retries_total", opLabels(op), static_cast<double>(op.retries));
+			appendHeader(out, "hbase_client_sent_bytes_total", "counter", "Bytes written to the socket, including frame headers.");
+			for (const COpSnapshot &op : metrics.tables) appendValue(out, "hbase_client_sent_bytes_total", opLabels(op), static_cast<double>(op.bytes_sent));
+			appendHeader(out, "hbase_client_received_bytes_total", "counter", "Bytes read from the socket, including frame headers.");
+			for (const COpSnapshot &op : metrics.tables) appendValue(out, "hbase_client_received_bytes_total", opLabels(op), static_cast<double>(op.bytes_received));
+			appendHeader(out, "hbase_client_request_duration_seconds", "summary", "Request latency including retries, by operation and table.");
+			for (const COpSnapshot &op : metrics.tables) appendSummary(out, "hbase_client_request_duration_seconds", opLabels(op), op.latency);
+			appendHeader(out, "hbase_client_op_duration_seconds", "summary", "Request latency including retries, by operation across all tables.");	// λܿӣ
+			for (const COpSnapshot &op : metrics.ops) appendSummary(out, "hbase_client_op_duration_seconds", opLabels(op), op.latency);
+			return out;
+		}
+	}
+}
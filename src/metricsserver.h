@@ -0,0 +1,33 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <thrift/transport/TServerSocket.h>
+#include "hbaseclient.h"
+
+namespace hbase {
+	namespace thrift2 {
+
+		// Ƕ /metrics ӿڣ Prometheus ıʽӳء;͸ӳٷλ/
+		// һ̨߳ TServerSocket ֻ֧ GETɼÿʮץȡһΣʺϸ߲
+		class CMetricsServer
+		{
+		public:
+			explicit CMetricsServer(CHBaseThrift &thrift);
+			~CMetricsServer();
+
+			bool start(int port, const std::string &host = "0.0.0.0");
+			void stop();
+			static std::string format(const CHBaseMetricsSnapshot &metrics, const CHBasePoolStats &pool);	// ˿ʱ
+		private:
+			void serve();
+			void handle(std::shared_ptr<apache::thrift::transport::TTransport> client);
+
+			CHBaseThrift												&m_thrift;
+			std::shared_ptr<apache::thrift::transport::TServerSocket>	m_socket;
+			std::thread													m_thread;
+			std::atomic<bool>											m_running;
+		};
+	}
+}
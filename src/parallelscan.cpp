@@ -0,0 +1,202 @@
+#include <algorithm>
+#include "parallelscan.h"
+#include "regionlocator.h"
+#include "columnarbatch.h"
+#include "log.h"
+
+namespace hbase {
+	namespace thrift2 {
+
+		CParallelScan::CParallelScan(CHBaseThrift &thrift) :m_thrift(thrift), m_parallelism(4), m_ordered(true), m_acquireTimeout(3000), m_nCacheRows(100),
+			m_nPrefetch(1), m_nextScan(0), m_running(0), m_failed(false), m_curQueue(0)
+		{
+		}
+
+		CParallelScan::~CParallelScan()
+		{
+			close();
+		}
+
+		void CParallelScan::setParallelism(const int &count)
+		{
+			m_parallelism = count > 0 ? count : 1;
+		}
+
+		void CParallelScan::setOrdered(const bool &ordered)
+		{
+			m_ordered = ordered;
+		}
+
+		void CParallelScan::setAcquireTimeout(const int &timeout)
+		{
+			m_acquireTimeout = timeout;
+		}
+
+		bool CParallelScan::execScan(const std::string &table, CScan &scan)	// ̣߳ﲻʱٿ߳
+		{
+			close();
+			if (!splitScan(table, scan)) return false;
+
+			std::vector<CHBaseQuery *> queries;
+			int workers = std::min<int>(m_parallelism, static_cast<int>(m_subScans.size()));
+			CHBaseQuery *query = m_thrift.getQuery(m_acquireTimeout);
+			while (query)
+			{
+				queries.push_back(query);
+				if (static_cast<int>(queries.size()) >= workers) break;
+				query = m_thrift.getQuery(0);
+			}
+			if (queries.empty())
+			{
+				LERROR("parallel scan {} get query failed", table.c_str());
+				m_subScans.clear();
+				return false;
+			}
+
+			size_t queues = m_ordered ? m_subScans.size() : std::min<size_t>(m_subScans.size(), 1);
+			for (size_t i = 0; i < queues; ++i)
+			{
+				m_queues.emplace_back(new CBatchQueue(m_ordered ? m_nPrefetch : m_nPrefetch * m_parallelism));
+			}
+			m_running = static_cast<int>(queries.size());
+			for (CHBaseQuery *worker_query : queries)
+			{
+				m_workers.emplace_back(&CParallelScan::scanWorker, this, worker_query);
+			}
+			return true;
+		}
+
+		void CParallelScan::close()
+		{
+			m_nextScan = m_subScans.size();		// ȡµɨ
+			for (auto &queue : m_queues) queue->close();	//  push Ĺ߳˳
+			for (auto &worker : m_workers) worker.join();
+			m_workers.clear();
+			m_queues.clear();
+			m_subScans.clear();
+			m_result.clear();
+			m_nextScan = 0;
+			m_curQueue = 0;
+			m_failed = false;
+		}
+
+		bool CParallelScan::splitScan(const std::string &table, CScan &scan)	// ɨÿ region  [startKey, endKey) 󽻼
+		{
+			m_table = table;
+			m_nCacheRows = scan.m_nCacheRows > 0 ? scan.m_nCacheRows : 100;
+			m_nPrefetch = scan.m_nPrefetch > 0 ? scan.m_nPrefetch : 1;
+			apache::hadoop::hbase::thrift2::TScan tscan = scan.m_scan;
+			tscan.__set_caching(m_nCacheRows);
+
+			if (tscan.reversed)	// ɨ startRow ǱϽ磬 region ߽Բ룬Ϊһɨ
+			{
+				m_subScans.push_back(tscan);
+				return true;
+			}
+
+			std::shared_ptr<const CRegionLocator::CRegionMap> regions = m_thrift.getRegionLocator().getRegions(table);
+			if (!regions) return false;
+
+			std::vector<std::string> bounds(1);		//  startKey ֮Ϊһɨ裬ﱻ䲢ǰһ©
+			for (const auto &region : *regions)
+			{
+				if (!region.first.empty()) bounds.push_back(region.first);
+			}
+			const std::string &start = tscan.startRow;
+			const std::string &stop = tscan.stopRow;	// ձʾɨβ
+			for (size_t i = 0; i < bounds.size(); ++i)
+			{
+				const std::string &sub_start = std::max(start, bounds[i]);
+				std::string sub_stop = stop;
+				if (i + 1 < bounds.size() && (sub_stop.empty() || bounds[i + 1] < sub_stop)) sub_stop = bounds[i + 1];
+				if (!sub_stop.empty() && sub_start >= sub_stop) continue;
+
+				apache::hadoop::hbase::thrift2::TScan sub = tscan;
+				sub.__set_startRow(sub_start);
+				sub.__set_stopRow(sub_stop);
+				m_subScans.push_back(sub);
+			}
+			LDEBUG("parallel scan {} split into {} regions", table, m_subScans.size());
+			return true;
+		}
+
+		void CParallelScan::scanWorker(CHBaseQuery *query)	// ˳ȡɨ裬֤ģʽСδɨһ߳
+		{
+			for (size_t index = m_nextScan++; index < m_subScans.size(); index = m_nextScan++)
+			{
+				bool more = !m_failed && scanRegion(query, index);	// ɨʧʱټ
+				if (m_ordered) m_queues[index]->close();
+				if (!more) break;
+			}
+			m_thrift.releaseQuery(query, query->getConnection()->is_connected());
+			if (--m_running == 0)		// һ˳̹߳رʣУȡһֱȴ
+			{
+				for (auto &queue : m_queues) queue->close();
+			}
+		}
+
+		bool CParallelScan::scanRegion(CHBaseQuery *query, size_t index)	//  CHBaseQuery 򿪲ȡʱָ false ʾʧܻѱ close
+		{
+			CBatchQueue &queue = m_ordered ? *m_queues[index] : *m_queues[0];
+			CScan scan;
+			scan.m_scan = m_subScans[index];
+			scan.m_nCacheRows = m_nCacheRows;
+			query->reset();
+			if (query->openScanner(m_table, scan))
+			{
+				CResultBatch batch;
+				while (query->fetchBatch(batch))
+				{
+					if (!queue.push(std::move(batch)))
+					{
+						query->closeScanner();
+						return false;
+					}
+					batch = CResultBatch();
+				}
+			}
+			HBaseError error = query->getLastError();
+			if (error == HBASE_OK) return true;
+			LERROR("parallel scan {} region [{}] failed: {}", m_table.c_str(), m_subScans[index].startRow.c_str(), static_cast<int>(error));
+			if (error == HBASE_IO_ERROR) m_thrift.getRegionLocator().invalidate(m_table, m_subScans[index].startRow);
+			m_failed = true;
+			return false;
+		}
+
+		bool CParallelScan::nextBatch()
+		{
+			while (m_curQueue < m_queues.size())
+			{
+				if (m_queues[m_curQueue]->pop(m_result)) return true;
+				if (m_failed) return false;		// Ѳ¶ hasError 
+				m_curQueue++;	// ǰɨѶ
+			}
+			return false;
+		}
+
+		bool CParallelScan::nextRow()
+		{
+			while (!m_result.nextRow())
+			{
+				if (!nextBatch()) return false;
+			}
+			return true;
+		}
+
+		bool CParallelScan::fetchColumnar(CColumnarBatch &columns)
+		{
+			columns.clear();
+			while (m_result.remaining() == 0)
+			{
+				if (!nextBatch()) return false;
+			}
+			columns.append(m_result);
+			return true;
+		}
+
+		bool CParallelScan::nextColumn()
+		{
+			return m_result.nextColumn();
+		}
+	}
+}
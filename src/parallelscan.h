@@ -0,0 +1,59 @@
+#pragma once
+#include <thread>
+#include "hbaseclient.h"
+
+namespace hbase {
+	namespace thrift2 {
+
+		//  region з CScanÿ region һɨ裬ֱռӳеһӲִ
+		//  execScan ʱõһɨʧܺ nextRow/fetchColumnar ǰ falsehasError Ϊ true
+		// ̲߳ȫֹ̹߳һ CParallelScan
+		class CParallelScan
+		{
+		public:
+			explicit CParallelScan(CHBaseThrift &thrift);
+			~CParallelScan();
+
+			void setParallelism(const int &count);			// ͬʱִеɨ
+			void setOrdered(const bool &ordered = true);	// true  rowkey ˳򷵻أfalse ˭ȵ˭(ʺϾۺ)
+			void setAcquireTimeout(const int &timeout);		// execScan ȴһӵĺ
+			bool execScan(const std::string &table, CScan &scan);	// зʧܻȲӷ false
+			void close();
+			bool nextRow();
+			bool nextColumn();
+			CRowRange<CParallelScan> rows() { return CRowRange<CParallelScan>(*this); }
+			bool fetchColumnar(CColumnarBatch &columns);	// ȡʽģʽʺۺ
+			CRowRef getRow() const { return m_result.getRow(); }
+			const CCell &getCell() const { return m_result.getCell(); }
+			bool hasError() const { return m_failed; }		// ɨʧʱnextRow  false 
+			CStringView getRowkey() const { return m_result.getRowkey(); }
+			CStringView getFamilyName() const { return m_result.getFamilyName(); }
+			CStringView getColumnName() const { return m_result.getColumnName(); }
+			CStringView getColumnValue() const { return m_result.getColumnValue(); }
+			uint64_t getTimestamp() const { return m_result.getTimestamp(); }
+		private:
+			typedef threadsafe_bounded_queue<CResultBatch>					CBatchQueue;
+
+			bool splitScan(const std::string &table, CScan &scan);
+			void scanWorker(CHBaseQuery *query);
+			bool scanRegion(CHBaseQuery *query, size_t index);
+			bool nextBatch();
+
+			CHBaseThrift														&m_thrift;
+			int																	m_parallelism;
+			bool																m_ordered;
+			int																	m_acquireTimeout;
+			std::string															m_table;
+			std::vector<apache::hadoop::hbase::thrift2::TScan>					m_subScans;		//  rowkey źɨ
+			int																	m_nCacheRows;
+			int																	m_nPrefetch;
+			std::atomic<size_t>													m_nextScan;		// һȡɨ
+			std::atomic<int>													m_running;		// еĹ߳
+			std::atomic<bool>													m_failed;
+			std::vector<std::unique_ptr<CBatchQueue>>							m_queues;		// ģʽÿɨһУģʽһ
+			size_t																m_curQueue;
+			std::vector<std::thread>											m_workers;
+			CResultBatch														m_result;		// ǰμα
+		};
+	}
+}
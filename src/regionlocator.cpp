@@ -0,0 +1,101 @@
+#include "regionlocator.h"
+#include "log.h"
+
+namespace hbase {
+	namespace thrift2 {
+
+		CRegionLocator::CRegionLocator(CHBaseThrift &thrift) :m_thrift(thrift)
+		{
+
+		}
+
+		std::shared_ptr<const CRegionLocator::CRegionMap> CRegionLocator::getSnapshot(const std::string &table)
+		{
+			boost::shared_lock<boost::shared_mutex> lock(m_mutex);
+			auto found = m_tables.find(table);
+			return found == m_tables.end() ? nullptr : found->second;
+		}
+
+		std::shared_ptr<const CRegionLocator::CRegionMap> CRegionLocator::getRegions(const std::string &table)
+		{
+			std::shared_ptr<const CRegionMap> snapshot = getSnapshot(table);
+			if (snapshot) return snapshot;
+
+			std::vector<THRegionLocation> locations;
+			CHBaseQuery *query = m_thrift.getQuery();
+			if (!query) return nullptr;
+			bool ret = query->getRegionLocations(table, locations);
+			m_thrift.releaseQuery(query, ret);
+			if (!ret) return nullptr;
+
+			std::shared_ptr<CRegionMap> regions = std::make_shared<CRegionMap>();
+			for (THRegionLocation &location : locations)
+			{
+				std::string start_key = location.regionInfo.startKey;
+				(*regions)[start_key] = std::move(location);
+			}
+			LDEBUG("load {} regions of {}", regions->size(), table);
+			boost::unique_lock<boost::shared_mutex> lock(m_mutex);
+			m_tables[table] = regions;
+			return regions;
+		}
+
+		bool CRegionLocator::locate(const std::string &table, const std::string &row, THRegionLocation &location)
+		{
+			std::shared_ptr<const CRegionMap> regions = getRegions(table);
+			if (!regions) return false;
+			const THRegionLocation *region = findRegion(*regions, row);
+			if (region)
+			{
+				location = *region;
+				return true;
+			}
+
+			CHBaseQuery *query = m_thrift.getQuery();	// ڱֻһ region
+			if (!query) return false;
+			bool ret = query->getRegionLocation(table, row, location, true);
+			m_thrift.releaseQuery(query, ret);
+			if (!ret) return false;
+
+			boost::unique_lock<boost::shared_mutex> lock(m_mutex);
+			std::shared_ptr<const CRegionMap> &current = m_tables[table];
+			std::shared_ptr<CRegionMap> filled = current ? std::make_shared<CRegionMap>(*current) : std::make_shared<CRegionMap>();
+			(*filled)[location.regionInfo.startKey] = location;
+			current = filled;
+			return true;
+		}
+
+		void CRegionLocator::invalidate(const std::string &table, const std::string &row)
+		{
+			boost::unique_lock<boost::shared_mutex> lock(m_mutex);
+			auto found = m_tables.find(table);
+			if (found == m_tables.end()) return;
+			const THRegionLocation *region = findRegion(*found->second, row);
+			if (!region) return;
+			std::shared_ptr<CRegionMap> regions = std::make_shared<CRegionMap>(*found->second);
+			regions->erase(region->regionInfo.startKey);
+			found->second = regions;
+		}
+
+		void CRegionLocator::invalidate(const std::string &table, HBaseError error, const std::string &row)
+		{
+			if (error == HBASE_IO_ERROR) invalidate(table, row);
+		}
+
+		void CRegionLocator::invalidate(const std::string &table)
+		{
+			boost::unique_lock<boost::shared_mutex> lock(m_mutex);
+			m_tables.erase(table);
+		}
+
+		const THRegionLocation *CRegionLocator::findRegion(const CRegionMap &regions, const std::string &row)	// һ startKey <= row  region
+		{
+			CRegionMap::const_iterator iter = regions.upper_bound(row);
+			if (iter == regions.begin()) return nullptr;
+			--iter;
+			const std::string &end_key = iter->second.regionInfo.endKey;
+			if (!end_key.empty() && row >= end_key) return nullptr;		// ڱ
+			return &iter->second;
+		}
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <map>
+#include "hbaseclient.h"
+
+namespace hbase {
+	namespace thrift2 {
+
+		// region λû棬 getAllRegionLocations Ľrowkey  startKey ֲ region
+		// ֻĳϵ󷵻 TIOError ʱŶ䣬´β鵽նʱ getRegionLocation 
+		// ̰߳ȫдʱƵĿգȡ
+		class CRegionLocator
+		{
+		public:
+			typedef std::map<std::string, THRegionLocation>	CRegionMap;		// startKey -> region
+
+			explicit CRegionLocator(CHBaseThrift &thrift);
+			~CRegionLocator() {}
+
+			std::shared_ptr<const CRegionMap> getRegions(const std::string &table);	// δʱأʧܷؿ
+			bool locate(const std::string &table, const std::string &row, THRegionLocation &location);
+			void invalidate(const std::string &table, const std::string &row);			//  row ڵ region
+			void invalidate(const std::string &table, HBaseError error, const std::string &row);	// ֻ TIOError Ŷ
+			void invalidate(const std::string &table);
+			static const THRegionLocation *findRegion(const CRegionMap &regions, const std::string &row);
+		private:
+			std::shared_ptr<const CRegionMap> getSnapshot(const std::string &table);
+
+			CHBaseThrift																&m_thrift;
+			boost::shared_mutex															m_mutex;
+			std::unordered_map<std::string, std::shared_ptr<const CRegionMap>>			m_tables;
+		};
+	}
+}
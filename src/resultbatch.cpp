@@ -0,0 +1,226 @@
+#include <string.h>
+#include "resultbatch.h"
+#include <thrift/TApplicationException.h>
+#include "hbase/Hbase_types.h"
+
+using apache::thrift::protocol::TProtocol;
+using apache::thrift::protocol::TType;
+
+namespace hbase {
+	namespace thrift2 {
+
+		CResultBatch::CResultBatch() :m_nextRow(0), m_currRow(0), m_nextCell(0), m_currCell(0)
+		{
+		}
+
+		void CResultBatch::clear()	// ֻݣһν
+		{
+			m_arena.reset();
+			m_rows.clear();
+			m_cells.clear();
+			m_nextRow = m_currRow = 0;
+			m_nextCell = m_currCell = 0;
+		}
+
+		bool CResultBatch::nextRow()
+		{
+			if (m_nextRow >= m_rows.size()) return false;
+			m_currRow = m_nextRow++;
+			m_nextCell = m_rows[m_currRow].cell_begin;
+			return true;
+		}
+
+		bool CResultBatch::nextColumn()
+		{
+			if (m_nextCell >= m_rows[m_currRow].cell_end) return false;
+			m_currCell = m_nextCell++;
+			return true;
+		}
+
+		CRowRef CResultBatch::getRow() const
+		{
+			const CRow &row = m_rows[m_currRow];
+			return CRowRef(row.row, m_cells.data() + row.cell_begin, m_cells.data() + row.cell_end);
+		}
+
+		void CResultBatch::recvResult(TProtocol *iprot, const char *method)
+		{
+			recv(iprot, method, false, false);
+		}
+
+		void CResultBatch::recvResults(TProtocol *iprot, const char *method)
+		{
+			recv(iprot, method, true, false);
+		}
+
+		void CResultBatch::appendResult(TProtocol *iprot, const char *method)
+		{
+			recv(iprot, method, false, true);
+		}
+
+		void CResultBatch::appendEmptyRow()
+		{
+			CRow row = { CStringView(), static_cast<uint32_t>(m_cells.size()), static_cast<uint32_t>(m_cells.size()) };
+			m_rows.push_back(row);
+		}
+
+		void CResultBatch::recv(TProtocol *iprot, const char *method, bool list, bool append)	// ɴ recv_xxx һ£ֻ success ֱֶӽ뵽
+		{
+			int32_t rseqid = 0;
+			std::string fname;
+			apache::thrift::protocol::TMessageType mtype;
+			iprot->readMessageBegin(fname, mtype, rseqid);
+			readReply(iprot, fname, mtype, method, list, append);
+		}
+
+		void CResultBatch::recvReply(TProtocol *iprot, const std::string &fname, apache::thrift::protocol::TMessageType mtype, const char *method, bool list)
+		{
+			readReply(iprot, fname, mtype, method, list, false);
+		}
+
+		void CResultBatch::readReply(TProtocol *iprot, const std::string &fname, apache::thrift::protocol::TMessageType mtype, const char *method, bool list, bool append)
+		{
+			if (!append) clear();
+			if (mtype == apache::thrift::protocol::T_EXCEPTION)
+			{
+				apache::thrift::TApplicationException x;
+				x.read(iprot);
+				iprot->readMessageEnd();
+				iprot->getTransport()->readEnd();
+				throw x;
+			}
+			if (mtype != apache::thrift::protocol::T_REPLY || fname != method)
+			{
+				iprot->skip(apache::thrift::protocol::T_STRUCT);
+				iprot->readMessageEnd();
+				iprot->getTransport()->readEnd();
+				throw apache::thrift::TApplicationException(mtype != apache::thrift::protocol::T_REPLY ?
+					apache::thrift::TApplicationException::INVALID_MESSAGE_TYPE : apache::thrift::TApplicationException::WRONG_METHOD_NAME);
+			}
+
+			bool success = false;
+			bool has_io = false;
+			bool has_ia = false;
+			apache::hadoop::hbase::thrift2::TIOError io;
+			apache::hadoop::hbase::thrift2::TIllegalArgument ia;
+			std::string name;
+			TType ftype;
+			int16_t fid;
+			iprot->readStructBegin(name);
+			for (;;)
+			{
+				iprot->readFieldBegin(name, ftype, fid);
+				if (ftype == apache::thrift::protocol::T_STOP) break;
+				if (fid == 0 && list && ftype == apache::thrift::protocol::T_LIST)
+				{
+					TType etype;
+					uint32_t size;
+					iprot->readListBegin(etype, size);
+					m_rows.reserve(size);
+					for (uint32_t i = 0; i < size; ++i) readResult(iprot);
+					iprot->readListEnd();
+					success = true;
+				}
+				else if (fid == 0 && !list && ftype == apache::thrift::protocol::T_STRUCT)
+				{
+					readResult(iprot);
+					success = true;
+				}
+				else if (fid == 1 && ftype == apache::thrift::protocol::T_STRUCT)
+				{
+					io.read(iprot);
+					has_io = true;
+				}
+				else if (fid == 2 && ftype == apache::thrift::protocol::T_STRUCT)
+				{
+					ia.read(iprot);
+					has_ia = true;
+				}
+				else
+				{
+					iprot->skip(ftype);
+				}
+				iprot->readFieldEnd();
+			}
+			iprot->readStructEnd();
+			iprot->readMessageEnd();
+			iprot->getTransport()->readEnd();
+
+			if (success) return;
+			if (!append) clear();
+			if (has_io) throw io;
+			if (has_ia) throw ia;
+			throw apache::thrift::TApplicationException(apache::thrift::TApplicationException::MISSING_RESULT, std::string(method) + " failed: unknown result");
+		}
+
+		uint32_t CResultBatch::readResult(TProtocol *iprot)	// TResult: 1 row, 2 columnValues
+		{
+			uint32_t xfer = 0;
+			std::string fname;
+			TType ftype;
+			int16_t fid;
+			CRow row = { CStringView(), static_cast<uint32_t>(m_cells.size()), 0 };
+			xfer += iprot->readStructBegin(fname);
+			for (;;)
+			{
+				xfer += iprot->readFieldBegin(fname, ftype, fid);
+				if (ftype == apache::thrift::protocol::T_STOP) break;
+				if (fid == 1 && ftype == apache::thrift::protocol::T_STRING)
+				{
+					xfer += readBinary(iprot, row.row);
+				}
+				else if (fid == 2 && ftype == apache::thrift::protocol::T_LIST)
+				{
+					TType etype;
+					uint32_t size;
+					xfer += iprot->readListBegin(etype, size);
+					m_cells.reserve(m_cells.size() + size);
+					for (uint32_t i = 0; i < size; ++i) xfer += readColumnValue(iprot);
+					xfer += iprot->readListEnd();
+				}
+				else
+				{
+					xfer += iprot->skip(ftype);
+				}
+				xfer += iprot->readFieldEnd();
+			}
+			xfer += iprot->readStructEnd();
+			row.cell_end = static_cast<uint32_t>(m_cells.size());
+			m_rows.push_back(row);
+			return xfer;
+		}
+
+		uint32_t CResultBatch::readColumnValue(TProtocol *iprot)	// TColumnValue: 1 family, 2 qualifier, 3 value, 4 timestamp(tags )
+		{
+			uint32_t xfer = 0;
+			std::string fname;
+			TType ftype;
+			int16_t fid;
+			CCell cell = { CStringView(), CStringView(), CStringView(), 0 };
+			xfer += iprot->readStructBegin(fname);
+			for (;;)
+			{
+				xfer += iprot->readFieldBegin(fname, ftype, fid);
+				if (ftype == apache::thrift::protocol::T_STOP) break;
+				if (fid == 1 && ftype == apache::thrift::protocol::T_STRING) xfer += readBinary(iprot, cell.family);
+				else if (fid == 2 && ftype == apache::thrift::protocol::T_STRING) xfer += readBinary(iprot, cell.qualifier);
+				else if (fid == 3 && ftype == apache::thrift::protocol::T_STRING) xfer += readBinary(iprot, cell.value);
+				else if (fid == 4 && ftype == apache::thrift::protocol::T_I64) xfer += iprot->readI64(cell.timestamp);
+				else xfer += iprot->skip(ftype);
+				xfer += iprot->readFieldEnd();
+			}
+			xfer += iprot->readStructEnd();
+			m_cells.push_back(cell);
+			return xfer;
+		}
+
+		uint32_t CResultBatch::readBinary(TProtocol *iprot, CStringView &view)
+		{
+			uint32_t xfer = iprot->readBinary(m_scratch);
+			char *data = m_arena.allocate(m_scratch.size());
+			memcpy(data, m_scratch.data(), m_scratch.size());
+			view = CStringView(data, m_scratch.size());
+			return xfer;
+		}
+	}
+}
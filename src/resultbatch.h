@@ -0,0 +1,117 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "boost/utility/string_view.hpp"
+#include <thrift/protocol/TProtocol.h>
+#include "container.h"
+
+namespace hbase {
+	namespace thrift2 {
+
+		typedef boost::string_view CStringView;
+
+		struct CCell	// һУֶǽڴͼ
+		{
+			CStringView	family;
+			CStringView	qualifier;
+			CStringView	value;
+			int64_t		timestamp;
+		};
+
+		class CRowRef	// һмȫУfor (const CCell &cell : row) ڴ
+		{
+		public:
+			CRowRef(CStringView rowkey, const CCell *first, const CCell *last) :m_rowkey(rowkey), m_first(first), m_last(last) {}
+			CStringView rowkey() const { return m_rowkey; }
+			const CCell *begin() const { return m_first; }
+			const CCell *end() const { return m_last; }
+			size_t size() const { return m_last - m_first; }
+			bool empty() const { return m_first == m_last; }
+		private:
+			CStringView		m_rowkey;
+			const CCell		*m_first;
+			const CCell		*m_last;
+		};
+
+		template<class Cursor>
+		class CRowRange	//  nextRow/getRow αװ: for (const CRowRef &row : query.rows())ʽɨԶ
+		{
+		public:
+			class iterator
+			{
+			public:
+				explicit iterator(Cursor *cursor) :m_cursor(cursor) { advance(); }
+				CRowRef operator*() const { return m_cursor->getRow(); }
+				iterator &operator++() { advance(); return *this; }
+				bool operator==(const iterator &other) const { return m_cursor == other.m_cursor; }
+				bool operator!=(const iterator &other) const { return m_cursor != other.m_cursor; }
+			private:
+				void advance() { if (m_cursor && !m_cursor->nextRow()) m_cursor = NULL; }
+				Cursor		*m_cursor;		// NULL ʾ
+			};
+
+			explicit CRowRange(Cursor &cursor) :m_cursor(&cursor) {}
+			iterator begin() const { return iterator(m_cursor); }	// ÿ begin α굱ǰλֻܱһ
+			iterator end() const { return iterator(NULL); }
+		private:
+			Cursor			*m_cursor;
+		};
+
+		// һ get/getMultiple/getScannerRows/getScannerResults Ӧȫ
+		//  TResultrow/family/qualifier/value ο monotonic_arenaкָֻ arena ͼ
+		// clear ֻλ arena αꡢͬһ CResultBatch ȶ malloc
+		// get* ص CStringView һν롢clear ֮ǰЧ
+		class CResultBatch
+		{
+		public:
+			CResultBatch();
+
+			void clear();
+			bool empty() const { return m_rows.empty(); }
+			size_t size() const { return m_rows.size(); }
+			size_t remaining() const { return m_rows.size() - m_nextRow; }		// û nextRow 
+			void recvResult(apache::thrift::protocol::TProtocol *iprot, const char *method);	//  send_get Ӧ𣬽Ϊ TResult
+			void recvResults(apache::thrift::protocol::TProtocol *iprot, const char *method);	// Ϊ list<TResult> Ӧ
+			void appendResult(apache::thrift::protocol::TProtocol *iprot, const char *method);	// ͬ recvResult׷֮
+			void appendEmptyRow();																// ռλһһӦ
+			void recvReply(apache::thrift::protocol::TProtocol *iprot, const std::string &fname,	// ÷Ѷ readMessageBegin(ͻ˰ seqid ַ)
+				apache::thrift::protocol::TMessageType mtype, const char *method, bool list);
+
+			bool nextRow();
+			bool nextColumn();
+			CRowRange<CResultBatch> rows() { return CRowRange<CResultBatch>(*this); }
+			CRowRef getRow() const;													// nextRow ֮ĵǰ
+			const CCell &getCell() const { return m_cells[m_currCell]; }				// nextColumn ֮ĵǰ
+			friend class CColumnarBatch;
+			CStringView getRowkey() const { return m_rows[m_currRow].row; }
+			CStringView getFamilyName() const { return m_cells[m_currCell].family; }
+			CStringView getColumnName() const { return m_cells[m_currCell].qualifier; }
+			CStringView getColumnValue() const { return m_cells[m_currCell].value; }
+			uint64_t getTimestamp() const { return m_cells[m_currCell].timestamp; }
+		private:
+			struct CRow
+			{
+				CStringView	row;
+				uint32_t	cell_begin;		// [cell_begin, cell_end) Ϊ m_cells е
+				uint32_t	cell_end;
+			};
+
+			void recv(apache::thrift::protocol::TProtocol *iprot, const char *method, bool list, bool append);
+			void readReply(apache::thrift::protocol::TProtocol *iprot, const std::string &fname,
+				apache::thrift::protocol::TMessageType mtype, const char *method, bool list, bool append);
+			uint32_t readResult(apache::thrift::protocol::TProtocol *iprot);
+			uint32_t readColumnValue(apache::thrift::protocol::TProtocol *iprot);
+			uint32_t readBinary(apache::thrift::protocol::TProtocol *iprot, CStringView &view);
+
+			monotonic_arena		m_arena;
+			std::string			m_scratch;		// readBinary ת
+			std::vector<CRow>	m_rows;
+			std::vector<CCell>	m_cells;
+			size_t				m_nextRow;
+			size_t				m_currRow;
+			size_t				m_nextCell;
+			size_t				m_currCell;
+		};
+	}
+}
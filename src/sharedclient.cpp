@@ -0,0 +1,246 @@
+#include "sharedclient.h"
+#include "log.h"
+
+namespace hbase {
+	namespace thrift2 {
+
+		void CConcurrentHBaseClient::recvBatch(CResultBatch &batch, const int32_t seqid, const char *method, bool list)	// ɴ recv_xxx(seqid) ͬĵȴ/ַ
+		{
+			int32_t rseqid = 0;
+			std::string fname;
+			apache::thrift::protocol::TMessageType mtype;
+
+			// waitForWork ڼͷŶsentry ʱȴ
+			apache::thrift::async::TConcurrentRecvSentry sentry(&this->sync_, seqid);
+			for (;;)
+			{
+				if (!this->sync_.getPending(fname, mtype, rseqid))
+				{
+					iprot_->readMessageBegin(fname, mtype, rseqid);
+				}
+				if (seqid == rseqid)
+				{
+					try
+					{
+						batch.recvReply(iprot_, fname, mtype, method, list);
+					}
+					catch (apache::thrift::transport::TTransportException&)
+					{
+						throw;		// ѻ commit
+					}
+					catch (apache::thrift::protocol::TProtocolException&)
+					{
+						throw;
+					}
+					catch (apache::thrift::TApplicationException&)
+					{
+						if (mtype == apache::thrift::protocol::T_EXCEPTION) sentry.commit();	// ˷ص쳣Կ
+						throw;		// Ӧ͡Իȱٽͬɴ벻 commitsentry ʱӱΪѻ
+					}
+					catch (apache::thrift::TException&)
+					{
+						sentry.commit();	// 쳣Կ
+						throw;
+					}
+					sentry.commit();
+					return;
+				}
+				this->sync_.updatePending(fname, mtype, rseqid);
+				this->sync_.waitForWork(seqid);
+			}
+		}
+
+		//////////////////////////////////////////////// CHBaseSharedClient ///////////////////////////////////////////////////
+		CHBaseSharedClient::CHBaseSharedClient(const CHBasePrivate &pri, CHBaseMetrics *metrics) :m_private(pri), m_pMetrics(metrics), m_retryTimes(2), m_next(0)
+		{
+		}
+
+		CHBaseSharedClient::~CHBaseSharedClient()
+		{
+			close();
+		}
+
+		bool CHBaseSharedClient::open(int connections)
+		{
+			CHBaseConnPool::parseHostList(m_private.host_list, m_servers);
+			LDEBUG("open hbase shared client {}[{}]", m_private.host_list, connections);
+			std::lock_guard<std::mutex> lk(m_mutex);
+			m_conns.resize(connections > 0 ? connections : 1);
+			for (auto &conn : m_conns) conn = createConnection();
+			return true;
+		}
+
+		void CHBaseSharedClient::close()
+		{
+			std::lock_guard<std::mutex> lk(m_mutex);
+			m_conns.clear();	// ʹõ̳߳ shared_ptr֮ر
+		}
+
+		std::shared_ptr<CHBaseSharedClient::CConnection> CHBaseSharedClient::createConnection()
+		{
+			std::shared_ptr<CConnection> conn = std::make_shared<CConnection>(m_servers, m_private.connect_timeout, m_private.recive_timeout,
+				m_private.send_timeout, 1, 60, 1, true, true, m_private.transport, m_private.protocol);
+			if (!conn->connect()) return nullptr;
+			return conn;
+		}
+
+		std::shared_ptr<CHBaseSharedClient::CConnection> CHBaseSharedClient::getConnection()
+		{
+			size_t slot = 0;
+			{
+				std::lock_guard<std::mutex> lk(m_mutex);
+				if (m_conns.empty()) return nullptr;
+				slot = m_next++ % m_conns.size();
+				if (m_conns[slot]) return m_conns[slot];
+			}
+			std::shared_ptr<CConnection> conn = createConnection();		// ⽨ʧܵĲλ´
+			if (!conn) return nullptr;
+			std::lock_guard<std::mutex> lk(m_mutex);
+			if (slot >= m_conns.size()) return conn;
+			if (!m_conns[slot]) m_conns[slot] = conn;
+			return m_conns[slot];
+		}
+
+		void CHBaseSharedClient::dropConnection(const std::shared_ptr<CConnection> &conn)	// õӲܾ͵λ̻߳Գʱ
+		{
+			if (m_pMetrics) m_pMetrics->addReconnect();
+			std::lock_guard<std::mutex> lk(m_mutex);
+			for (auto &slot : m_conns)
+			{
+				if (slot == conn) slot.reset();
+			}
+		}
+
+		template<class Call>
+		HBaseError CHBaseSharedClient::call(const char *msg, HBaseOp op, const std::string &table, Call request)
+		{
+			std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+			int retry_count = 0;
+			if (m_pMetrics) m_pMetrics->beginRequest();
+			HBaseError error = retryCall(msg, table, request, retry_count);
+			if (m_pMetrics)		// ̹߳ãÿβ()
+			{
+				m_pMetrics->endRequest();
+				uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+				m_pMetrics->getTable(table)[op].record(us, retry_count, error == HBASE_OK, 0, 0);
+			}
+			return error;
+		}
+
+		template<class Call>
+		HBaseError CHBaseSharedClient::retryCall(const char *msg, const std::string &table, Call request, int &retry_count)
+		{
+			HBaseError error = HBASE_TRANSPORT_ERROR;
+			for (int i = 0; i < m_retryTimes; ++i)
+			{
+				retry_count = i;
+				std::shared_ptr<CConnection> conn = getConnection();
+				if (!conn) continue;
+				try
+				{
+					request(*conn);
+					return HBASE_OK;
+				}
+				catch (apache::hadoop::hbase::thrift2::TIOError& ex)
+				{
+					LERROR("{} {} IOError: {}", msg, table.c_str(), ex.message.c_str());
+					error = HBASE_IO_ERROR;
+				}
+				catch (apache::thrift::transport::TTransportException& ex)
+				{
+					LERROR("{} {} transport exception: ({}){}", msg, table.c_str(), ex.getType(), ex.what());
+					error = HBASE_TRANSPORT_ERROR;
+					dropConnection(conn);
+				}
+				catch (apache::thrift::TApplicationException& ex)
+				{
+					LERROR("{} {} application exception: ({}){}", msg, table.c_str(), ex.getType(), ex.what());
+					error = HBASE_APPLICATION_ERROR;
+					if (ex.getType() == apache::thrift::TApplicationException::WRONG_METHOD_NAME || ex.getType() == apache::thrift::TApplicationException::INVALID_MESSAGE_TYPE
+						|| ex.getType() == apache::thrift::TApplicationException::MISSING_RESULT) dropConnection(conn);	// ӦѶԲϣӱΪѻ
+				}
+				catch (apache::hadoop::hbase::thrift2::TIllegalArgument& ex)
+				{
+					LERROR("{} {} exception: {}", msg, table.c_str(), ex.message.c_str());
+					error = HBASE_ILLEGAL_ARGUMENT;
+				}
+				catch (apache::thrift::protocol::TProtocolException& ex)
+				{
+					LERROR("{} {} protocol exception: ({}){}", msg, table.c_str(), ex.getType(), ex.what());
+					error = HBASE_PROTOCOL_ERROR;
+					dropConnection(conn);
+				}
+			}
+			return error;
+		}
+
+		HBaseError CHBaseSharedClient::execGet(const std::string &table, CGet &get, CResultBatch &result)
+		{
+			return call("shared get from", HBASE_OP_GET, table, [&](CConnection &conn) {
+				int32_t seqid = conn->send_get(table, get.m_get);
+				conn->recvBatch(result, seqid, "get", false);
+			});
+		}
+
+		HBaseError CHBaseSharedClient::execMulitGet(const std::string &table, CMulitGet &mulit_get, CResultBatch &result)
+		{
+			return call("shared mulit get from", HBASE_OP_MULIT_GET, table, [&](CConnection &conn) {
+				int32_t seqid = conn->send_getMultiple(table, mulit_get.m_gets);
+				conn->recvBatch(result, seqid, "getMultiple", true);
+			});
+		}
+
+		HBaseError CHBaseSharedClient::execScan(const std::string &table, CScan &scan, CResultBatch &result)
+		{
+			apache::hadoop::hbase::thrift2::TScan tscan = scan.m_scan;		// ܹ߳̿ͬһ CScanĶ
+			tscan.__set_caching(scan.m_nCacheRows * static_cast<int32_t>(tscan.columns.size()));
+			return call("shared scan from", HBASE_OP_SCAN, table, [&](CConnection &conn) {
+				int32_t seqid = conn->send_getScannerResults(table, tscan, scan.m_nCacheRows);
+				conn->recvBatch(result, seqid, "getScannerResults", true);
+			});
+		}
+
+		HBaseError CHBaseSharedClient::execPut(const std::string &table, CPut &put)
+		{
+			put.m_put.__set_columnValues(put.m_familys);
+			return call("shared put to", HBASE_OP_PUT, table, [&](CConnection &conn) {
+				int32_t seqid = conn->send_put(table, put.m_put);
+				conn->recv_put(seqid);
+			});
+		}
+
+		HBaseError CHBaseSharedClient::execMulitPut(const std::string &table, CMulitPut &mulit_put)
+		{
+			return call("shared mulit put to", HBASE_OP_MULIT_PUT, table, [&](CConnection &conn) {
+				int32_t seqid = conn->send_putMultiple(table, mulit_put.m_puts);
+				conn->recv_putMultiple(seqid);
+			});
+		}
+
+		HBaseError CHBaseSharedClient::execMulitDelete(const std::string &table, CMulitDelete &mulit_delete, CMulitDelete *failed)
+		{
+			std::vector<apache::hadoop::hbase::thrift2::TDelete> pending;		// ˷δɾУһֻⲿ
+			const std::vector<apache::hadoop::hbase::thrift2::TDelete> *deletes = &mulit_delete.m_deletes;
+			HBaseError error = call("shared mulit delete from", HBASE_OP_MULIT_DELETE, table, [&](CConnection &conn) {
+				std::vector<apache::hadoop::hbase::thrift2::TDelete> rest;
+				int32_t seqid = conn->send_deleteMultiple(table, *deletes);
+				conn->recv_deleteMultiple(rest, seqid);
+				if (!rest.empty())
+				{
+					LERROR("shared mulit delete from {} failed {}/{}", table.c_str(), rest.size(), deletes->size());
+					pending.swap(rest);
+					deletes = &pending;
+					apache::hadoop::hbase::thrift2::TIOError io;
+					io.__set_message("some deletes failed");
+					throw io;
+				}
+			});
+			if (failed)
+			{
+				if (error == HBASE_OK) failed->clear();
+				else failed->m_deletes = *deletes;
+			}
+			return error;
+		}
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <mutex>
+#include "hbaseclient.h"
+
+namespace hbase {
+	namespace thrift2 {
+
+		// ɵĲͻˣӰ seqid Ӧֱӽ뵽 CResultBatch  recv
+		class CConcurrentHBaseClient : public THBaseServiceConcurrentClient
+		{
+		public:
+			explicit CConcurrentHBaseClient(std::shared_ptr<apache::thrift::protocol::TProtocol> prot) :THBaseServiceConcurrentClient(prot) {}
+			void recvBatch(CResultBatch &batch, const int32_t seqid, const char *method, bool list);
+		};
+
+		// ̹߳ӣÿ seqidӦڶ̰߳ seqid ַ(THBaseServiceConcurrentClient)
+		// ͬһͬʱֻһ߳дһ߳ڶ̵߳ԼӦ߳
+		//  framed ģʽ(setProtocol(THRIFT_TRANSPORT_FRAMED))Ϣ߽
+		// ̰߳ȫ֧ʽɨ裬д÷ CResultBatch
+		class CHBaseSharedClient
+		{
+		public:
+			typedef CThriftClientHelper<CConcurrentHBaseClient> CConnection;
+
+			explicit CHBaseSharedClient(const CHBasePrivate &pri, CHBaseMetrics *metrics = NULL);	// metrics ֻ¼ӳ١Ժʹӹãͳֽ
+			~CHBaseSharedClient();
+
+			bool open(int connections);
+			void close();
+			void setRetryTimes(const int &count) { m_retryTimes = count; }
+			HBaseError execGet(const std::string &table, CGet &get, CResultBatch &result);
+			HBaseError execMulitGet(const std::string &table, CMulitGet &mulit_get, CResultBatch &result);
+			HBaseError execScan(const std::string &table, CScan &scan, CResultBatch &result);		// һȡ scan ȫ(getScannerResults)
+			HBaseError execPut(const std::string &table, CPut &put);
+			HBaseError execMulitPut(const std::string &table, CMulitPut &mulit_put);
+			HBaseError execMulitDelete(const std::string &table, CMulitDelete &mulit_delete, CMulitDelete *failed = NULL);	// ͬ CHBaseQuery::execMulitDelete
+		private:
+			template<class Call>
+			HBaseError call(const char *msg, HBaseOp op, const std::string &table, Call request);
+			template<class Call>
+			HBaseError retryCall(const char *msg, const std::string &table, Call request, int &retry_count);	// retry_count ΪһγԵ±
+			std::shared_ptr<CConnection> getConnection();
+			std::shared_ptr<CConnection> createConnection();
+			void dropConnection(const std::shared_ptr<CConnection> &conn);
+
+			CHBasePrivate									m_private;
+			CHBaseMetrics									*m_pMetrics;
+			std::vector<std::pair<std::string, int>>		m_servers;
+			int												m_retryTimes;
+			std::mutex										m_mutex;		// ֻ m_conns Ĳλ
+			std::vector<std::shared_ptr<CConnection>>		m_conns;		// ϿĲλΪգ´ȡʱؽ
+			std::atomic<size_t>								m_next;			// ѯ±
+		};
+	}
+}
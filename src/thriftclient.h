@@ -1,14 +1,60 @@
 #pragma once
+#include <atomic>
 #include <memory>
+#include <chrono>
 #include <string>
+#include <poll.h>
 #include <thrift/thrift-config.h>
 #include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/protocol/TCompactProtocol.h>
 #include <thrift/transport/TSocketPool.h>
 #include <thrift/transport/TBufferTransports.h>
 #include <thrift/transport/TTransportException.h>
 #include "commonest.h"
 #include "log.h"
 
+enum ThriftTransportType	// һ£hbase thrift2 server  -f ʱΪ framednonblocking/hsha ģʽֻ֧ framed
+{
+	THRIFT_TRANSPORT_BUFFERED = 0,
+	THRIFT_TRANSPORT_FRAMED,
+};
+
+enum ThriftProtocolType		// һ£hbase thrift2 server  -c ʱΪ compact
+{
+	THRIFT_PROTOCOL_BINARY = 0,
+	THRIFT_PROTOCOL_COMPACT,
+};
+
+struct CTransportCounter		// ۼշֽ frame ͷ
+{
+	std::atomic<uint64_t>	sent{ 0 };
+	std::atomic<uint64_t>	received{ 0 };
+};
+
+//  socket һ Transport ֮ϵЭȻдֻշʱһԭӼ
+template <class Socket>
+class CCountingSocket : public Socket
+{
+public:
+	template <class... Args>
+	CCountingSocket(CTransportCounter &counter, Args&&... args) :Socket(std::forward<Args>(args)...), _counter(counter) {}
+
+	uint32_t read(uint8_t* buf, uint32_t len)
+	{
+		uint32_t got = Socket::read(buf, len);
+		_counter.received.fetch_add(got, std::memory_order_relaxed);
+		return got;
+	}
+
+	void write(const uint8_t* buf, uint32_t len)
+	{
+		Socket::write(buf, len);
+		_counter.sent.fetch_add(len, std::memory_order_relaxed);
+	}
+private:
+	CTransportCounter	&_counter;
+};
+
 //apache::thrift::protocol::TBinaryProtocol,apache::thrift::transport::TFramedTransport
 template <class ThriftClient>
 class CThriftClientHelper
@@ -22,14 +68,18 @@ public:
 	// receive_timeout_milliseconds thrift˷ݵĳʱ
 	// send_timeout_milliseconds thrift˷ʱĳʱ
 	// set_log_function Ƿд־ĬΪdebug־
+	// transport_type 㣬protocol_type Э
 	CThriftClientHelper(const std::string &host, uint16_t port,int connect_timeout_milliseconds = 2000,
-		int receive_timeout_milliseconds = 2000,int send_timeout_milliseconds = 2000)
+		int receive_timeout_milliseconds = 2000,int send_timeout_milliseconds = 2000,
+		ThriftTransportType transport_type = THRIFT_TRANSPORT_BUFFERED, ThriftProtocolType protocol_type = THRIFT_PROTOCOL_BINARY)
 		: _connect_timeout_milliseconds(connect_timeout_milliseconds),
 		_receive_timeout_milliseconds(receive_timeout_milliseconds),
-		_send_timeout_milliseconds(send_timeout_milliseconds)
+		_send_timeout_milliseconds(send_timeout_milliseconds),
+		_transport_type(transport_type),
+		_protocol_type(protocol_type)
 	{
 		apache::thrift::GlobalOutput.setOutputFunction(ThriftLog);
-		_socket.reset(new apache::thrift::transport::TSocket(host, port));
+		_socket.reset(new CCountingSocket<apache::thrift::transport::TSocket>(_counter, host, port));
 		init();
 	}
 
@@ -40,19 +90,23 @@ public:
 	// randomize_ ǷѡһServer
 	// always_try_last ǷһServer
 	// set_log_function Ƿд־ĬΪdebug־
+	// transport_type 㣬protocol_type Э
 	CThriftClientHelper(const std::vector<std::pair<std::string, int> >& servers,
 		int connect_timeout_milliseconds = 2000,
 		int receive_timeout_milliseconds = 2000,
 		int send_timeout_milliseconds = 2000,
 		int num_retries = 1, int retry_interval = 60,
 		int max_consecutive_failures = 1,
-		bool randomize = true, bool always_try_last = true)
+		bool randomize = true, bool always_try_last = true,
+		ThriftTransportType transport_type = THRIFT_TRANSPORT_BUFFERED, ThriftProtocolType protocol_type = THRIFT_PROTOCOL_BINARY)
 		: _connect_timeout_milliseconds(connect_timeout_milliseconds),
 		_receive_timeout_milliseconds(receive_timeout_milliseconds),
-		_send_timeout_milliseconds(send_timeout_milliseconds)
+		_send_timeout_milliseconds(send_timeout_milliseconds),
+		_transport_type(transport_type),
+		_protocol_type(protocol_type)
 	{
 		apache::thrift::GlobalOutput.setOutputFunction(ThriftLog);
-		apache::thrift::transport::TSocketPool* socket_pool = new apache::thrift::transport::TSocketPool(servers);
+		apache::thrift::transport::TSocketPool* socket_pool = new CCountingSocket<apache::thrift::transport::TSocketPool>(_counter, servers);
 		socket_pool->setNumRetries(num_retries);
 		socket_pool->setRetryInterval(retry_interval);
 		socket_pool->setMaxConsecutiveFailures(max_consecutive_failures);
@@ -81,6 +135,7 @@ public:
 			{
 				// TransportΪTFramedTransportʵʵãTFramedTransport::open -> TSocketPool::open
 				_transport->open();
+				_last_used = _last_check = std::chrono::steady_clock::now();
 				// "TSocketPool::open: all connections failed"ʱTSocketPool::open׳쳣TTransportException쳣ΪTTransportException::NOT_OPEN
 			}
 		}
@@ -108,6 +163,17 @@ public:
 		return _transport && _transport->isOpen();
 	}
 
+	// ز鿴 socketϲӦпɶ¼ɶ˵ԶѹرջϴεӦ𣬶
+	bool is_alive() const
+	{
+		if (!is_connected() || !_socket) return false;
+		struct pollfd fds;
+		fds.fd = _socket->getSocketFD();
+		fds.events = POLLIN;
+		fds.revents = 0;
+		return poll(&fds, 1, 0) == 0;
+	}
+
 
 	// Ͽthrift˵
 	// ʱ׳¼thrift쳣
@@ -140,6 +206,9 @@ public:
 	ThriftClient* operator ->() { return get(); }
 	ThriftClient* operator ->() const { return get(); }
 
+	uint64_t bytes_sent() const { return _counter.sent.load(std::memory_order_relaxed); }
+	uint64_t bytes_received() const { return _counter.received.load(std::memory_order_relaxed); }
+
 	// ؿɶıʶڼ¼־
 	uint16_t get_port() const 	// ȡthrift˵Ķ˿ں
 	{
@@ -157,27 +226,50 @@ public:
 	}
 
 private:
+	template <class Transport>
+	void initProtocol(const std::shared_ptr<Transport> &transport)
+	{
+		_transport = transport;
+		// ProtocolĬΪapache::thrift::protocol::TBinaryProtocol
+		if (_protocol_type == THRIFT_PROTOCOL_COMPACT)
+		{
+			_protocol.reset(new apache::thrift::protocol::TCompactProtocolT<Transport>(transport, DEFAULT_MAX_STRING_SIZE, 0));
+		}
+		else
+		{
+			apache::thrift::protocol::TBinaryProtocolT<Transport> *protocol = new apache::thrift::protocol::TBinaryProtocolT<Transport>(transport);
+			protocol->setStringSizeLimit(DEFAULT_MAX_STRING_SIZE);
+			protocol->setStrict(false, false);
+			_protocol.reset(protocol);
+		}
+	}
+
 	void init()
 	{
 		_socket->setConnTimeout(_connect_timeout_milliseconds);
 		_socket->setRecvTimeout(_receive_timeout_milliseconds);
 		_socket->setSendTimeout(_send_timeout_milliseconds);
 
-		// TransportĬΪapache::thrift::transport::TFramedTransport
-		_transport.reset(new apache::thrift::transport::TBufferedTransport(_socket));
-		// ProtocolĬΪapache::thrift::protocol::TBinaryProtocol
-		_protocol.reset(new apache::thrift::protocol::TBinaryProtocol(_transport));
+		// TransportĬΪapache::thrift::transport::TBufferedTransport
+		// Protocol  Transport ʵ(TBinaryProtocolT<TBufferedTransport> )Эдֶʱ
+		// ֱ TBufferBase::readAll/write Ļ·پ TTransport 麯
+		if (_transport_type == THRIFT_TRANSPORT_FRAMED)
+			initProtocol(std::make_shared<apache::thrift::transport::TFramedTransport>(_socket));
+		else
+			initProtocol(std::make_shared<apache::thrift::transport::TBufferedTransport>(_socket));
 		// ˵Client
 		_client.reset(new ThriftClient(_protocol));
-
-		dynamic_cast<apache::thrift::protocol::TBinaryProtocol*>(_protocol.get())->setStringSizeLimit(DEFAULT_MAX_STRING_SIZE);
-		dynamic_cast<apache::thrift::protocol::TBinaryProtocol*>(_protocol.get())->setStrict(false, false);
 	}
 
 public:
 	int																	_connect_timeout_milliseconds;
 	int																	_receive_timeout_milliseconds;
 	int																	_send_timeout_milliseconds;
+	ThriftTransportType													_transport_type;
+	ThriftProtocolType													_protocol_type;
+	std::chrono::steady_clock::time_point								_last_used;		// һαҵʹõʱ
+	std::chrono::steady_clock::time_point								_last_check;	// һα̽ʱ
+	CTransportCounter													_counter;		//  _socket 죬 _socket
 
 
 	// TSocketֻ֧һserverTSocketPoolTSocketָ֧serverʱѡһ